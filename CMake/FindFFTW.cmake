@@ -4,6 +4,7 @@
 #  FFTW_INCLUDE_DIR, where to find fftw3.h, etc.
 #  FFTW_LIBRARIES, the libraries needed to use FFTW.
 #  FFTW_FOUND, If false, do not try to use FFTW.
+#  FFTW_THREADS_FOUND, If true, FFTW_THREADS_LIBRARY is the fftw3_threads library.
 # also defined, but not for general use are
 #  FFTW_LIBRARY, where to find the FFTW library.
 
@@ -29,6 +30,24 @@ FIND_LIBRARY(FFTW_LIBRARY
     /usr/lib
   )
 
+# The threads part is optional, large transforms are planned on several threads with it
+SET(FFTW_THREADS_NAMES ${FFTW_THREADS_NAMES} fftw3_threads fftw3-3_threads)
+FIND_LIBRARY(FFTW_THREADS_LIBRARY
+  NAMES
+    ${FFTW_THREADS_NAMES}
+  PATHS
+    /usr/local/lib64
+    /opt/local/lib64
+    /usr/lib64
+    /usr/local/lib
+    /opt/local/lib
+    /usr/lib
+  )
+
+if (FFTW_THREADS_LIBRARY AND FFTW_INCLUDE_DIR)
+	  set (FFTW_THREADS_FOUND TRUE)
+endif(FFTW_THREADS_LIBRARY AND FFTW_INCLUDE_DIR)
+
 
 if (FFTW_INCLUDE_DIR AND FFTW_LIBRARY)
 	  set (FFTW_FOUND TRUE)
@@ -25,6 +25,8 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <zlib.h>
+#include <algorithm>
   
 ZipMaker::ZipMaker() :
     m_zDoc(NULL)
@@ -115,6 +117,64 @@ bool ZipMaker::AddFromBuffer(const char *innerFile, const char *buffer, unsigned
     return true;
 }
 
+bool ZipMaker::AddRaw(const char *innerFile, int method, const char *data, unsigned int dataSize,
+                      unsigned long uncompressedSize, unsigned long crc)
+{
+    assert(innerFile);
+    assert(m_zDoc);
+    int level = 0;
+
+    if (method == Z_DEFLATED){
+        level = m_opt_compress_level;
+        if (level < Z_DEFAULT_COMPRESSION  || level > Z_BEST_COMPRESSION){
+            level = Z_DEFAULT_COMPRESSION;
+        }
+    }
+
+    // raw, the data is written as it is
+    if (zipOpenNewFileInZip2((zipFile)m_zDoc,innerFile,(zip_fileinfo*)m_zi,
+                                NULL,0,NULL,0,NULL ,
+                                method,
+                                level, 1) != ZIP_OK){
+        strcpy(m_error, "zipOpenNewFileInZip2 error");
+        return false;
+    }
+
+    if (dataSize > 0 && zipWriteInFileInZip((zipFile)m_zDoc, data, dataSize) != ZIP_OK){
+        strcpy(m_error, "zipWriteInFileInZip error");
+        zipCloseFileInZipRaw((zipFile)m_zDoc, uncompressedSize, crc);
+        return false;
+    }
+
+    if (zipCloseFileInZipRaw((zipFile)m_zDoc, uncompressedSize, crc) != ZIP_OK){
+        strcpy(m_error, "zipCloseFileInZipRaw error");
+        return false;
+    }
+
+    return true;
+}
+
+bool ZipMaker::AddEmpty(const char *innerFile, const char *comment)
+{
+    assert(innerFile);
+    assert(m_zDoc);
+
+    if (zipOpenNewFileInZip((zipFile)m_zDoc,innerFile,(zip_fileinfo*)m_zi,
+                                NULL,0,NULL,0,comment,
+                                0,
+                                0) != ZIP_OK){
+        strcpy(m_error, "zipOpenNewFileInZip error");
+        return false;
+    }
+
+    if (zipCloseFileInZip((zipFile)m_zDoc) != ZIP_OK){
+        strcpy(m_error, "zipCloseFileInZip error");
+        return false;
+    }
+
+    return true;
+}
+
 bool ZipMaker::AddFromFile(const char *localFile, const char *innerFile)
 {
     assert(localFile);
@@ -162,6 +222,259 @@ const char *ZipMaker::GetError()
     return NULL;
 }
 
+//-----------------ZipDeflater
+
+ZipDeflater::ZipDeflater(ZipMaker &maker, bool bStore) :
+    m_maker(maker)
+{
+    m_store = bStore;
+    m_level = maker.m_opt_compress_level;
+    if (m_level < Z_DEFAULT_COMPRESSION  || m_level > Z_BEST_COMPRESSION){
+        m_level = Z_DEFAULT_COMPRESSION;
+    }
+
+    m_exit = false;
+    m_error[0] = 0;
+
+    // The caller thread writes the file, the others compress
+    int threads = (int)std::thread::hardware_concurrency() - 1;
+    threads = std::max(threads, 1);
+    m_window = threads * 2;
+
+    for (int i = 0; i < threads; i++){
+        m_threads.push_back(std::thread(&ZipDeflater::WorkProc, this));
+    }
+}
+
+ZipDeflater::~ZipDeflater()
+{
+    Cancel();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_work_cond.notify_all();
+
+    for (auto &t : m_threads){
+        t.join();
+    }
+}
+
+bool ZipDeflater::Add(const char *innerFile, const char *buffer, unsigned int buferSize, bool ownBuffer)
+{
+    assert(innerFile);
+    assert(buffer || buferSize == 0);
+
+    if (m_error[0]){
+        if (ownBuffer)
+            free((void*)buffer);
+        return false;
+    }
+
+    Job *job = new Job();
+    job->name = innerFile;
+    job->buffer = buffer;
+    job->size = buferSize;
+    job->own_buffer = ownBuffer;
+    job->empty = false;
+    job->crc = 0;
+    job->done = false;
+    job->ok = false;
+
+    return Queue(job, true);
+}
+
+bool ZipDeflater::AddEmpty(const char *innerFile, const char *comment)
+{
+    assert(innerFile);
+
+    if (m_error[0]){
+        return false;
+    }
+
+    Job *job = new Job();
+    job->name = innerFile;
+    job->comment = comment ? comment : "";
+    job->buffer = NULL;
+    job->size = 0;
+    job->own_buffer = false;
+    job->empty = true;
+    job->crc = 0;
+    job->done = true;
+    job->ok = true;
+
+    return Queue(job, false);
+}
+
+bool ZipDeflater::Queue(Job *job, bool bCompress)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (bCompress)
+            m_todo.push_back(job);
+        m_order.push_back(job);
+    }
+    if (bCompress)
+        m_work_cond.notify_one();
+
+    // Only waits when the window is full
+    return WriteDone(false);
+}
+
+bool ZipDeflater::Finish()
+{
+    return WriteDone(true);
+}
+
+void ZipDeflater::Cancel()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Not taken by a worker yet
+    for (Job *job : m_todo){
+        job->done = true;
+    }
+    m_todo.clear();
+
+    while (!m_order.empty()){
+        Job *job = m_order.front();
+        m_done_cond.wait(lock, [job]{ return job->done; });
+        m_order.pop_front();
+        ReleaseJob(job);
+    }
+}
+
+const char *ZipDeflater::GetError()
+{
+    if (m_error[0])
+        return m_error;
+    return NULL;
+}
+
+bool ZipDeflater::WriteDone(bool bAll)
+{
+    while (true)
+    {
+        Job *job = NULL;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            if (m_order.empty())
+                break;
+
+            if (bAll || (int)m_order.size() > m_window){
+                m_done_cond.wait(lock, [this]{ return m_order.front()->done; });
+            }
+            else if (!m_order.front()->done){
+                break;
+            }
+
+            job = m_order.front();
+            m_order.pop_front();
+        }
+
+        if (m_error[0] == 0){
+            bool ret = false;
+
+            if (!job->ok){
+                strcpy(m_error, "deflate error");
+            }
+            else if (job->empty){
+                ret = m_maker.AddEmpty(job->name.c_str(), job->comment.c_str());
+            }
+            else if (m_store){
+                ret = m_maker.AddRaw(job->name.c_str(), 0, job->buffer,
+                                job->size, job->size, job->crc);
+            }
+            else{
+                ret = m_maker.AddRaw(job->name.c_str(), Z_DEFLATED, job->data.data(),
+                                (unsigned int)job->data.size(), job->size, job->crc);
+            }
+
+            if (job->ok && !ret){
+                const char *err = m_maker.GetError();
+                strcpy(m_error, err ? err : "zip write error");
+            }
+        }
+        ReleaseJob(job);
+    }
+
+    return m_error[0] == 0;
+}
+
+void ZipDeflater::WorkProc()
+{
+    while (true)
+    {
+        Job *job = NULL;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work_cond.wait(lock, [this]{ return m_exit || !m_todo.empty(); });
+            if (m_todo.empty())
+                break;
+
+            job = m_todo.front();
+            m_todo.pop_front();
+        }
+
+        bool ok = m_store ? Store(job) : Deflate(job, m_level);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            job->ok = ok;
+            job->done = true;
+        }
+        m_done_cond.notify_all();
+    }
+}
+
+bool ZipDeflater::Deflate(Job *job, int level)
+{
+    // The same raw stream as zipWriteInFileInZip makes
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    if (deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK){
+        return false;
+    }
+
+    job->data.resize(deflateBound(&zs, job->size));
+    zs.next_in = (Bytef*)job->buffer;
+    zs.avail_in = job->size;
+    zs.next_out = (Bytef*)job->data.data();
+    zs.avail_out = (uInt)job->data.size();
+
+    int ret = deflate(&zs, Z_FINISH);
+    job->data.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    job->crc = crc32(0L, (const Bytef*)job->buffer, job->size);
+
+    // The source is not needed any more
+    if (job->own_buffer){
+        free((void*)job->buffer);
+        job->buffer = NULL;
+    }
+
+    return ret == Z_STREAM_END;
+}
+
+bool ZipDeflater::Store(Job *job)
+{
+    // The buffer is written later, by the caller thread
+    job->crc = crc32(0L, (const Bytef*)job->buffer, job->size);
+    return true;
+}
+
+void ZipDeflater::ReleaseJob(Job *job)
+{
+    if (job->own_buffer && job->buffer){
+        free((void*)job->buffer);
+    }
+    delete job;
+}
+
 //-----------------ZipReader
 
 ZipInnerFileData::ZipInnerFileData(char *data, int size)
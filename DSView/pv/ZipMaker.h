@@ -25,6 +25,12 @@
 
 #include <minizip/zip.h>
 #include <minizip/unzip.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
  
 
 class ZipMaker
@@ -49,6 +55,13 @@ public:
     //add a inner file from local file
     bool AddFromFile(const char *localFile, const char *innerFile);
 
+    //add a inner file whose data is deflated already, or stored if method is 0, see ZipDeflater
+    bool AddRaw(const char *innerFile, int method, const char *data, unsigned int dataSize,
+                unsigned long uncompressedSize, unsigned long crc);
+
+    //add a inner file without data, the comment describes it
+    bool AddEmpty(const char *innerFile, const char *comment);
+
     //get the last error
     const char *GetError();
 
@@ -62,6 +75,72 @@ private:
 };
 
 
+//------------------ZipDeflater
+//Compresses the inner files on a worker pool.
+//The caller thread writes the finished deflate streams to the ZipMaker,
+//in the order of Add(), so the archive is the same as with AddFromBuffer.
+//A stored deflater writes the data as it is, the workers only make the crc.
+class ZipDeflater
+{
+private:
+    struct Job
+    {
+        std::string name;
+        std::string comment; // the empty inner files only
+        const char *buffer;
+        unsigned int size;
+        bool own_buffer;
+        bool empty;
+        std::vector<char> data;
+        unsigned long crc;
+        bool done;
+        bool ok;
+    };
+
+public:
+    ZipDeflater(ZipMaker &maker, bool bStore = false);
+
+    ~ZipDeflater();
+
+    //queue a inner file, writes the finished ones
+    //a own buffer is released by free() once compressed
+    bool Add(const char *innerFile, const char *buffer, unsigned int buferSize, bool ownBuffer);
+
+    //queue a inner file without data, see ZipMaker::AddEmpty
+    bool AddEmpty(const char *innerFile, const char *comment);
+
+    //write all the queued inner files
+    bool Finish();
+
+    //drop the queued inner files
+    void Cancel();
+
+    //get the first error
+    const char *GetError();
+
+private:
+    bool Queue(Job *job, bool bCompress);
+    void WorkProc();
+    bool WriteDone(bool bAll);
+    static bool Deflate(Job *job, int level);
+    static bool Store(Job *job);
+    void ReleaseJob(Job *job);
+
+private:
+    ZipMaker        &m_maker;
+    int             m_level;
+    bool            m_store;
+    int             m_window; //the inner files in the memory
+    bool            m_exit;
+    char            m_error[500];
+    std::mutex      m_mutex;
+    std::condition_variable m_work_cond;
+    std::condition_variable m_done_cond;
+    std::vector<std::thread> m_threads;
+    std::deque<Job*> m_todo;
+    std::deque<Job*> m_order;
+};
+
 //------------------ZipReader
 class ZipInnerFileData
 {
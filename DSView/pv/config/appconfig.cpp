@@ -123,6 +123,9 @@ static void _loadApp(AppOptions &o, QSettings &st)
     getFiled("swapBackBufferAlways", st, o.swapBackBufferAlways, false);
     getFiled("fontSize", st, o.fontSize, 9.0);
     getFiled("autoScrollLatestData", st, o.autoScrollLatestData, true);
+    getFiled("decodeThreads", st, o.decodeThreads, 0);
+    getFiled("segmentDecode", st, o.segmentDecode, false);
+    getFiled("uncompressedSave", st, o.uncompressedSave, false);
     getFiled("version", st, o.version, 1);
 
     o.warnofMultiTrig = true;
@@ -160,6 +163,9 @@ static void _saveApp(AppOptions &o, QSettings &st)
     setFiled("swapBackBufferAlways", st, o.swapBackBufferAlways);
     setFiled("fontSize", st, o.fontSize);
     setFiled("autoScrollLatestData", st, o.autoScrollLatestData);
+    setFiled("decodeThreads", st, o.decodeThreads);
+    setFiled("segmentDecode", st, o.segmentDecode);
+    setFiled("uncompressedSave", st, o.uncompressedSave);
     setFiled("version", st, APP_CONFIG_VERSION);
 
     QString fmt =  FormatArrayToString(o.m_protocolFormats);
@@ -72,6 +72,9 @@ struct AppOptions
     bool  swapBackBufferAlways;
     bool  autoScrollLatestData;
     float fontSize;
+    int   decodeThreads; // 0: auto
+    bool  segmentDecode;
+    bool  uncompressedSave; // the logic blocks are stored, not deflated
 
     std::vector<StringPair> m_protocolFormats;
 };
@@ -27,6 +27,7 @@
 #include <algorithm>
  
 #include "analogsnapshot.h"
+#include "samplekernel.h"
 #include "../dsvdef.h"
 
 using namespace std;
@@ -46,6 +47,7 @@ AnalogSnapshot::AnalogSnapshot() :
 	memset(_envelope_levels, 0, sizeof(_envelope_levels));
     _unit_pitch = 0;
     _data  = NULL; 
+    _generation = 0;
 }
 
 AnalogSnapshot::~AnalogSnapshot()
@@ -76,6 +78,7 @@ void AnalogSnapshot::init_all()
     _ring_sample_count = 0;
     _memory_failed = false;
     _last_ended = true; 
+    _generation++;
 
     for (unsigned int i = 0; i < _channel_num; i++) {
         for (unsigned int level = 0; level < ScaleStepCount; level++) {
@@ -193,6 +196,7 @@ void AnalogSnapshot::append_payload(const sr_datafeed_analog &analog)
 {
     std::lock_guard<std::mutex> lock(_mutex);
     append_data(analog.data, analog.num_samples, analog.unit_pitch);
+    _generation++;
 
 	// Generate the first mip-map from the data
     if (analog.num_samples != 0) // guarantee new samples to compute
@@ -273,53 +277,51 @@ void AnalogSnapshot::reallocate_envelope(Envelope &e)
 	}
 }
 
+void AnalogSnapshot::append_envelope_level0(uint64_t start, uint64_t end)
+{
+    uint8_t *dest[DS_MAX_ANALOG_PROBES_NUM];
+
+    if (start >= end)
+        return;
+
+    for (int i = 0; i < (int)_channel_num; i++)
+        dest[i] = (uint8_t*)(_envelope_levels[i][0].samples + start);
+
+    // All channels of the groups in one pass
+    envelope_interleaved((uint8_t*)_data + start * EnvelopeScaleFactor * _channel_num * _unit_bytes,
+                         end - start, EnvelopeScaleFactor, _channel_num, _unit_bytes, dest);
+}
+
 void AnalogSnapshot::append_payload_to_envelope_levels()
 {
     int i;
+    uint64_t prev_length = 0;
+    uint64_t ring_length = 0;
+
     for (i = 0; i < (int)_channel_num; i++) {
         Envelope &e0 = _envelope_levels[i][0];
-        uint64_t prev_length;
-        EnvelopeSample *dest_ptr;
 
         // Expand the data buffer to fit the new samples
         e0.length = _sample_count / EnvelopeScaleFactor;
         prev_length = e0.ring_length;
         e0.ring_length = _ring_sample_count / EnvelopeScaleFactor;
+        ring_length = e0.ring_length;
+    }
 
-        if (e0.length == 0)
-            continue;
-
-        //reallocate_envelope(e0);
-
-        dest_ptr = e0.samples + prev_length;
-
-        // Iterate through the samples to populate the first level mipmap
-        const uint64_t src_size = _total_sample_count * _unit_bytes * _channel_num;
-        uint64_t e0_sample_num = (e0.ring_length > prev_length) ? e0.ring_length - prev_length :
-                                                                  e0.ring_length + (_total_sample_count / EnvelopeScaleFactor) - prev_length;
-        uint8_t *src_ptr = (uint8_t*)_data +
-                    (prev_length * EnvelopeScaleFactor * _channel_num + i) * _unit_bytes;
-        for (uint64_t j = 0; j < e0_sample_num; j++) {
-            const uint8_t *end_src_ptr =
-                src_ptr + EnvelopeScaleFactor * _unit_bytes * _channel_num;
-            if (end_src_ptr >= (uint8_t*)_data + src_size)
-                end_src_ptr -= src_size;
-            EnvelopeSample sub_sample;
-            sub_sample.min = *src_ptr;
-            sub_sample.max = *src_ptr;
-            src_ptr += _channel_num * _unit_bytes;
-            while(src_ptr != end_src_ptr) {
-                sub_sample.min = min(sub_sample.min, *src_ptr);
-                sub_sample.max = max(sub_sample.max, *src_ptr);
-                src_ptr += _channel_num * _unit_bytes;
-                if (src_ptr >= (uint8_t*)_data + src_size)
-                    src_ptr -= src_size;
-            }
+    if (_channel_num == 0 || _sample_count < (uint64_t)EnvelopeScaleFactor)
+        return;
 
-            *dest_ptr++ = sub_sample;
-            if (dest_ptr >= e0.samples + e0.count)
-                dest_ptr = e0.samples;
-        }
+    // Populate the first level mipmap, the new groups wrap at the ring end at most once
+    if (ring_length > prev_length) {
+        append_envelope_level0(prev_length, ring_length);
+    }
+    else {
+        append_envelope_level0(prev_length, _envelope_levels[0][0].count);
+        append_envelope_level0(0, ring_length);
+    }
+
+    for (i = 0; i < (int)_channel_num; i++) {
+        EnvelopeSample *dest_ptr;
 
         // Compute higher level mipmaps
         for (unsigned int level = 1; level < ScaleStepCount; level++)
@@ -433,5 +435,11 @@ bool AnalogSnapshot::has_enabled_channel(int index)
     return false; 
 }
 
+uint64_t AnalogSnapshot::get_generation()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _generation;
+}
+
 } // namespace data
 } // namespace pv
@@ -111,15 +111,20 @@ public:
 
     bool has_enabled_channel(int index);
 
+    // Changes whenever the samples change
+    uint64_t get_generation();
+
 private:
     void append_data(void *data, uint64_t samples, uint16_t pitch);
     void free_envelop();
 	void reallocate_envelope(Envelope &l);
 	void append_payload_to_envelope_levels();
+    void append_envelope_level0(uint64_t start, uint64_t end);
     void free_data();
 
 private:
     void *_data;
+    uint64_t _generation;
     struct Envelope _envelope_levels[DS_MAX_ANALOG_PROBES_NUM][ScaleStepCount];
 	friend class AnalogSnapshotTest::Basic;
     std::vector<int>        _enabled_channel_indexs;
@@ -37,11 +37,12 @@ namespace pv {
 namespace data {
 namespace decode {
 
-//create at DecoderStack.annotation_callback
+//create at DecoderStack.annotation_callback, stored by RowData
 class Annotation
 {
 public:
 	Annotation(const srd_proto_data *const pdata, DecoderStatus *status);
+	Annotation(uint64_t start, uint64_t end, int resIndex, DecoderStatus *status);
     Annotation();
 	~Annotation();
 
@@ -62,6 +63,10 @@ public:
 		return _type;
 	}  
 
+	inline int res_index() const{
+		return _resIndex;
+	}
+
 	bool is_numberic();
 
 	const std::vector<QString>& annotations() const;
@@ -22,6 +22,7 @@
 #include "annotationrestable.h"
 #include <assert.h>
 #include <stdlib.h> 
+#include <string.h>
 #include <math.h>
 #include "../../log.h"
 #include "../../dsvdef.h"
@@ -98,6 +99,29 @@ long long bin2long_string(const char *bin, int len)
 
 //-----------------------------------
 
+//FNV-1a
+static inline uint64_t hash_bytes(uint64_t hash, const char *data, int len)
+{
+    for (int i = 0; i < len; i++){
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static inline uint64_t hash_string(uint64_t hash, const char *str)
+{
+    //the end flag is hashed to split the lines
+    do {
+        hash ^= (unsigned char)*str;
+        hash *= 1099511628211ULL;
+    } while (*str++);
+
+    return hash;
+}
+
+#define HASH_SEED 14695981039346656037ULL
+
 AnnotationResTable::AnnotationResTable(){
 
   }
@@ -105,24 +129,155 @@ AnnotationResTable::AnnotationResTable(){
 AnnotationResTable::~AnnotationResTable(){
 	reset();
 }
+
+void AnnotationResTable::insert_slot(std::vector<int> &slots, uint64_t hash, int index)
+{
+    uint64_t mask = slots.size() - 1;
+    uint64_t i = hash & mask;
+
+    while (slots[i] != -1){
+        i = (i + 1) & mask;
+    }
+    slots[i] = index;
+}
+
+bool AnnotationResTable::is_same_item(AnnotationSourceItem *item, int format, int type, 
+                        char **ann_text, const char *number_hex, int number_len)
+{
+    if (item->format != format || item->type != type)
+        return false;
+
+    unsigned int n = 0;
+
+    while (ann_text && *ann_text) {
+        if ((*ann_text)[0] != '\n'){
+            if (n == item->line_ids.size()
+                || strcmp(m_lines[item->line_ids[n]]->text.c_str(), *ann_text) != 0){
+                return false;
+            }
+            n++;
+        }
+        ann_text++;
+    }
+
+    if (n != item->line_ids.size())
+        return false;
+
+    if (number_len == 0)
+        return item->str_number_hex == NULL;
+
+    return item->str_number_hex != NULL && strcmp(item->str_number_hex, number_hex) == 0;
+}
+
+int AnnotationResTable::intern_line(const char *text)
+{
+    uint64_t hash = hash_string(HASH_SEED, text);
+
+    if (m_line_slots.size() > 0)
+    {
+        uint64_t mask = m_line_slots.size() - 1;
+
+        for (uint64_t i = hash & mask; m_line_slots[i] != -1; i = (i + 1) & mask){
+            AnnotationTextLine *line = m_lines[m_line_slots[i]];
+            if (line->hash == hash && line->text == text){
+                return m_line_slots[i];
+            }
+        }
+    }
+
+    //keep the load factor under 1/2
+    if ((m_lines.size() + 1) * 2 > m_line_slots.size()){
+        m_line_slots.assign(m_line_slots.empty() ? 64 : m_line_slots.size() * 2, -1);
+        for (int i = 0; i < (int)m_lines.size(); i++){
+            insert_slot(m_line_slots, m_lines[i]->hash, i);
+        }
+    }
+
+    AnnotationTextLine *line = new AnnotationTextLine();
+    line->hash = hash;
+    line->text = text;
+    line->str = QString::fromUtf8(text);
+
+    int dex = m_lines.size();
+    m_lines.push_back(line);
+    insert_slot(m_line_slots, hash, dex);
+    return dex;
+}
  
-int AnnotationResTable::MakeIndex(const std::string &key, AnnotationSourceItem* &newItem)
-{   
-    auto fd = m_indexs.find(key);
-    if (fd != m_indexs.end()){
-        return (*fd).second;
-    } 
+int AnnotationResTable::MakeIndex(int format, int type, char **ann_text, const char *number_hex, 
+                                AnnotationSourceItem* &newItem)
+{
+    //a too long numerical value is not kept
+    int number_len = number_hex ? strlen(number_hex) : 0;
+    if (number_len > DECODER_MAX_DATA_BLOCK_LEN)
+        number_len = 0;
+
+    short key_format = (short)format;
+    short key_type = (short)type;
+    uint64_t hash = HASH_SEED;
+    hash = hash_bytes(hash, (const char*)&key_format, sizeof(key_format));
+    hash = hash_bytes(hash, (const char*)&key_type, sizeof(key_type));
+
+    for (char **p = ann_text; p && *p; p++){
+        if ((*p)[0] != '\n'){
+            hash = hash_string(hash, *p);
+        }
+    }
+    hash = hash_bytes(hash, number_hex, number_len);
+
+    if (m_slots.size() > 0)
+    {
+        uint64_t mask = m_slots.size() - 1;
+
+        for (uint64_t i = hash & mask; m_slots[i] != -1; i = (i + 1) & mask){
+            AnnotationSourceItem *item = m_resourceTable[m_slots[i]];
+            if (item->hash == hash
+                && is_same_item(item, key_format, key_type, ann_text, number_hex, number_len)){
+                return m_slots[i];
+            }
+        }
+    }
+
+    //keep the load factor under 1/2
+    if ((m_resourceTable.size() + 1) * 2 > m_slots.size()){
+        m_slots.assign(m_slots.empty() ? 256 : m_slots.size() * 2, -1);
+        for (int i = 0; i < (int)m_resourceTable.size(); i++){
+            insert_slot(m_slots, m_resourceTable[i]->hash, i);
+        }
+    }
   
     AnnotationSourceItem *item = new AnnotationSourceItem();
-    m_resourceTable.push_back(item);
 
     item->cur_display_format = -1;
     item->is_numeric = false;
 	item->str_number_hex = NULL;
+    item->format = key_format;
+    item->type = key_type;
+    item->hash = hash;
+
+    for (char **p = ann_text; p && *p; p++){
+        if ((*p)[0] != '\n'){
+            int id = intern_line(*p);
+            item->line_ids.push_back(id);
+            item->src_lines.push_back(m_lines[id]->str); //shared string data
+        }
+    }
+
+    //get numeric data
+    if (number_len > 0){
+        item->str_number_hex = (char*)malloc(number_len + 1);
+    
+        if (item->str_number_hex != NULL){
+            strcpy(item->str_number_hex, number_hex);
+            item->is_numeric = true;
+        }
+    }
+
     newItem = item;
    
-    int dex = m_indexs.size();
-    m_indexs[key] = dex;
+    int dex = m_resourceTable.size();
+    m_resourceTable.push_back(item);
+    insert_slot(m_slots, hash, dex);
     return dex;
 }
 
@@ -338,7 +493,13 @@ void AnnotationResTable::reset()
 		delete p;
 	}
 	m_resourceTable.clear();
-	m_indexs.clear();
+	m_slots.clear();
+
+	for (auto p : m_lines){
+		delete p;
+	}
+	m_lines.clear();
+	m_line_slots.clear();
 }
 
 int AnnotationResTable::hexToDecimal(char * hex)
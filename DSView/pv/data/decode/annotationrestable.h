@@ -21,7 +21,7 @@
 
 #pragma once
 
-#include <map>
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include <QString>
@@ -33,11 +33,23 @@ struct AnnotationSourceItem
 {
     bool    is_numeric;
     char    *str_number_hex; //numerical value hex format string
+    short   format; //annotation class
+    short   type;   //annotation type
+    uint64_t hash;  //of the class, type, text lines and numerical string
+    std::vector<int> line_ids; //the interned text lines
 
     std::vector<QString> src_lines; //the origin source string lines
     std::vector<QString> cvt_lines; //the converted to bin/hex/oct format string lines
     int     cur_display_format; //current format  as bin/ex/oct..., init with -1
 };
+
+//a text line shared by all items
+struct AnnotationTextLine
+{
+    uint64_t    hash;
+    std::string text; //utf8
+    QString     str;
+};
  
 class AnnotationResTable
 { 
@@ -46,7 +58,9 @@ class AnnotationResTable
     ~AnnotationResTable();
 
     public:
-       int MakeIndex(const std::string &key, AnnotationSourceItem* &newItem);
+       //find the item of an annotation, newItem is set when it is created
+       int MakeIndex(int format, int type, char **ann_text, const char *number_hex, 
+                        AnnotationSourceItem* &newItem);
        AnnotationSourceItem* GetItem(int index);
 
        inline int GetCount(){
@@ -62,9 +76,18 @@ class AnnotationResTable
     private:
         const char* format_to_string(const char *hex_str, int fmt);
 
+        bool is_same_item(AnnotationSourceItem *item, int format, int type, 
+                        char **ann_text, const char *number_hex, int number_len);
+        int  intern_line(const char *text);
+
+        static void insert_slot(std::vector<int> &slots, uint64_t hash, int index);
+
     private:
-        std::map<std::string, int>          m_indexs;
+        //open addressing tables of the indexes, with the hash in the items
+        std::vector<int>                    m_slots;
         std::vector<AnnotationSourceItem*>  m_resourceTable;
+        std::vector<int>                    m_line_slots;
+        std::vector<AnnotationTextLine*>    m_lines;
         char g_bin_format_tmp_buffer[DECODER_MAX_DATA_BLOCK_LEN * 4 + 2];
         char g_oct_format_tmp_buffer[DECODER_MAX_DATA_BLOCK_LEN * 3 + 2];
         char g_number_tmp_64[30];
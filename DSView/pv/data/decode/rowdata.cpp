@@ -22,6 +22,9 @@
 
 #include <math.h>
 #include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <thread>
 
 #include "rowdata.h"
 
@@ -33,119 +36,394 @@ namespace pv {
 namespace data {
 namespace decode {
 
-std::mutex RowData::_global_visitor_mutex;
+RowData::ReadScope::ReadScope(RowData *row)
+{
+    _row = row;
+    _row->_readers.fetch_add(1);
+
+    // The count is loaded first, the table published with it covers it.
+    // Both are sequenced with clear(), that resets them before it waits.
+    count = _row->_item_count.load();
+    table = _row->_table.load();
+
+    if (table == NULL)
+        count = 0;
+}
+
+RowData::ReadScope::~ReadScope()
+{
+    _row->_readers.fetch_sub(1, std::memory_order_release);
+}
 
-RowData::RowData() :
+RowData::RowData(DecoderStatus *status) :
     _max_annotation(0),
-    _min_annotation(0)
+    _min_annotation(0),
+    _item_count(0),
+    _table(NULL),
+    _readers(0)
 {
-    _item_count = 0;
+    _status = status;
+    _chunk_count = 0;
 }
 
 RowData::~RowData()
 {
-    //stack object can not destory the sources
+    clear();
 }
 
+// Called by the writer, or by the others when no decode task runs
 void RowData::clear()
 {
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
+    ChunkTable *table = _table.load(std::memory_order_relaxed);
+
+    _item_count.store(0);
+    _table.store(NULL);
+
+    // Wait for the readers that took the old table
+    while (_readers.load() != 0){
+        std::this_thread::yield();
+    }
+
+    if (table != NULL)
+    {
+        for (uint64_t i = 0; i < _chunk_count; i++){
+            AnnotationChunk *c = table->chunks[i];
+            free(c->far_start);
+            free(c->long_length);
+            free(c);
+        }
+        free(table);
+    }
 
-    //destroy objercts
-    for (Annotation *p : _annotations){
-        delete p;
+    for (ChunkTable *t : _retired_tables){
+        free(t);
     }
-    _annotations.clear();
-    _item_count = 0;
-    _min_annotation = 0;
+    _retired_tables.clear();
+
+    _chunk_count = 0;
+    _min_annotation.store(0, std::memory_order_relaxed);
 }
 
 uint64_t RowData::get_max_sample()
 {
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex); 
+    ReadScope rd(this);
 
-	if (_annotations.empty())
+	if (rd.count == 0)
 		return 0;
-	return _annotations.back()->end_sample();
+    
+    uint64_t start = get_start(rd.table, rd.count - 1);
+	return get_end(rd.table, rd.count - 1, start);
 }
 
 uint64_t RowData::get_max_annotation()
 {
-    return _max_annotation;
+    return _max_annotation.load(std::memory_order_relaxed);
 }
 
 uint64_t RowData::get_min_annotation()
 {
-    if (_min_annotation == 0)
+    const uint64_t v = _min_annotation.load(std::memory_order_relaxed);
+
+    if (v == 0)
         return 10;
     else
-        return _min_annotation;
+        return v;
 }
 
-void RowData::get_annotation_subset(std::vector<pv::data::decode::Annotation*> &dest,
+RowData::IndexBlock* RowData::get_block(const ChunkTable *table, uint64_t block)
+{
+    return &table->chunks[block / ChunkBlocks]->index[block % ChunkBlocks];
+}
+
+uint64_t RowData::get_start(const ChunkTable *table, uint64_t index)
+{
+    const AnnotationChunk *c = table->chunks[index / ChunkSize];
+    const int32_t delta = c->start_delta[index % ChunkSize];
+
+    if (delta == FarStart)
+        return c->far_start[index % ChunkSize];
+    return c->base + (int64_t)delta;
+}
+
+uint64_t RowData::get_end(const ChunkTable *table, uint64_t index, uint64_t start)
+{
+    const AnnotationChunk *c = table->chunks[index / ChunkSize];
+    const uint32_t len = c->length[index % ChunkSize];
+
+    if (len == LongLength)
+        return start + c->long_length[index % ChunkSize];
+    return start + len;
+}
+
+int RowData::get_res_index(const ChunkTable *table, uint64_t index)
+{
+    return table->chunks[index / ChunkSize]->res_index[index % ChunkSize];
+}
+
+template<class Pred>
+uint64_t RowData::partition_block(const ChunkTable *table, uint64_t first,
+                                  uint64_t last, Pred pred)
+{
+    while (first < last)
+    {
+        uint64_t mid = first + (last - first) / 2;
+
+        if (pred(*get_block(table, mid)))
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    return first;
+}
+
+void RowData::get_annotation_subset(std::vector<pv::data::decode::Annotation> &dest,
 		                        uint64_t start_sample, uint64_t end_sample)
 {  
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
+    ReadScope rd(this);
+
+    const uint64_t blocks = (rd.count + IndexBlockSize - 1) / IndexBlockSize;
+
+    // Blocks before all end at or before start_sample
+    uint64_t first = partition_block(rd.table, 0, blocks,
+        [start_sample](const IndexBlock &b){ return b.pre_max_end.get() <= start_sample; });
+
+    // Blocks after all start behind end_sample
+    uint64_t last = partition_block(rd.table, first, blocks,
+        [end_sample](const IndexBlock &b){ return b.suf_min_start.get() <= end_sample; });
 
-    for (Annotation *p : _annotations)
+    for (uint64_t k = first; k < last; k++)
     {
-        if (p->end_sample() > start_sample && p->start_sample() <= end_sample)
+        const IndexBlock *b = get_block(rd.table, k);
+
+        if (b->max_end.get() <= start_sample || b->min_start.get() > end_sample)
+            continue;
+
+        uint64_t i = k * IndexBlockSize;
+        uint64_t n = min(i + IndexBlockSize, rd.count);
+
+        for (; i < n; i++)
         {
-            dest.push_back(p);
-        }			               
+            uint64_t start = get_start(rd.table, i);
+            uint64_t end = get_end(rd.table, i, start);
+
+            if (end > start_sample && start <= end_sample)
+            {
+                dest.push_back(Annotation(start, end, get_res_index(rd.table, i), _status));
+            }
+        }
     }
 }
 
 uint64_t RowData::get_annotation_index(uint64_t start_sample)
 {
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
-    uint64_t index = 0;
+    ReadScope rd(this);
+
+    const uint64_t blocks = (rd.count + IndexBlockSize - 1) / IndexBlockSize;
 
-     for (Annotation *p : _annotations){
-         if (p->start_sample() > start_sample)
-             break;
-         index++;
-     }
+    // The first annotation that starts behind start_sample is in the first
+    // block that has one
+    uint64_t k = partition_block(rd.table, 0, blocks,
+        [start_sample](const IndexBlock &b){ return b.pre_max_start.get() <= start_sample; });
+
+    if (k == blocks)
+        return rd.count;
+
+    uint64_t index = k * IndexBlockSize;
+
+    while (index < rd.count
+        && get_start(rd.table, index) <= start_sample)
+        index++;
 
     return index;
 }
 
-bool RowData::push_annotation(Annotation *a)
+// Called before the annotation is published.
+// A reader may see the bounds of the last blocks before they are widened,
+// it only misses the annotations that are not published yet.
+void RowData::update_index(uint64_t start, uint64_t end)
+{
+    const ChunkTable *table = _table.load(std::memory_order_relaxed);
+    const uint64_t count = _item_count.load(std::memory_order_relaxed);
+    const uint64_t dex = count / IndexBlockSize;
+    IndexBlock *b = get_block(table, dex);
+
+    if (count % IndexBlockSize == 0)
+    {
+        uint64_t pre_max_start = start;
+        uint64_t pre_max_end = end;
+
+        if (dex > 0){
+            const IndexBlock *pb = get_block(table, dex - 1);
+            pre_max_start = max(pre_max_start, pb->pre_max_start.get());
+            pre_max_end = max(pre_max_end, pb->pre_max_end.get());
+        }
+
+        b->min_start.set(start);
+        b->max_end.set(end);
+        b->pre_max_start.set(pre_max_start);
+        b->pre_max_end.set(pre_max_end);
+        b->suf_min_start.set(start);
+    }
+    else
+    {
+        b->min_start.set(min(b->min_start.get(), start));
+        b->max_end.set(max(b->max_end.get(), end));
+        b->pre_max_start.set(max(b->pre_max_start.get(), start));
+        b->pre_max_end.set(max(b->pre_max_end.get(), end));
+        b->suf_min_start.set(min(b->suf_min_start.get(), start));
+    }
+
+    // Only an out of order annotation walks back
+    for (uint64_t i = dex; i > 0; i--){
+        IndexBlock *pb = get_block(table, i - 1);
+        if (pb->suf_min_start.get() <= start)
+            break;
+        pb->suf_min_start.set(start);
+    }
+}
+
+// Add a chunk to the table, the table is replaced when it is full
+bool RowData::add_chunk_self(uint64_t start)
+{
+    ChunkTable *table = _table.load(std::memory_order_relaxed);
+
+    if (table == NULL || _chunk_count == table->capacity)
+    {
+        uint64_t capacity = (table == NULL) ? 16 : table->capacity * 2;
+        ChunkTable *nt = (ChunkTable*)malloc(sizeof(ChunkTable) 
+                                + sizeof(AnnotationChunk*) * (capacity - 1));
+        if (nt == NULL)
+            return false;
+
+        nt->capacity = capacity;
+        for (uint64_t i = 0; i < _chunk_count; i++){
+            nt->chunks[i] = table->chunks[i];
+        }
+
+        try {
+            if (table != NULL)
+                _retired_tables.push_back(table);
+        } catch (const std::bad_alloc&) {
+            free(nt);
+            return false;
+        }
+
+        // The readers may still visit the old table until clear()
+        _table.store(nt, std::memory_order_release);
+        table = nt;
+    }
+
+    AnnotationChunk *c = (AnnotationChunk*)malloc(sizeof(AnnotationChunk));
+    if (c == NULL)
+        return false;
+
+    c->base = start;
+    c->far_start = NULL;
+    c->long_length = NULL;
+    table->chunks[_chunk_count++] = c;
+    return true;
+}
+
+bool RowData::push_annotation(const Annotation &a)
 { 
-    assert(a);
+    return push_annotation_self(a.start_sample(), a.end_sample(), a.res_index());
+}
 
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
+bool RowData::push_annotation_self(uint64_t start, uint64_t end, int resIndex)
+{
+    const uint64_t dex = _item_count.load(std::memory_order_relaxed);
+    const uint64_t off = dex % ChunkSize;
+
+    // A chunk of a failed push is kept for the next one
+    if (dex / ChunkSize == _chunk_count && !add_chunk_self(start))
+        return false;
 
-    try {
-      _annotations.push_back(a);
-      _item_count = _annotations.size();
-      _max_annotation = max(_max_annotation, a->end_sample() - a->start_sample());
+    AnnotationChunk *c = _table.load(std::memory_order_relaxed)->chunks[dex / ChunkSize];
+    const int64_t delta = (int64_t)(start - c->base);
+    const uint64_t len = end - start;
 
-      if (a->end_sample() != a->start_sample()){
-        if (_min_annotation == 0){
-            _min_annotation = a->end_sample() - a->start_sample();
+    if (delta > INT32_MAX || delta <= INT32_MIN)
+    {
+        if (c->far_start == NULL){
+            c->far_start = (uint64_t*)malloc(sizeof(uint64_t) * ChunkSize);
+            if (c->far_start == NULL)
+                return false;
         }
-        else{
-            _min_annotation = min(_min_annotation, a->end_sample() - a->start_sample());
+        c->far_start[off] = start;
+        c->start_delta[off] = FarStart;
+    }
+    else{
+        c->start_delta[off] = (int32_t)delta;
+    }
+
+    if (len >= LongLength)
+    {
+        if (c->long_length == NULL){
+            c->long_length = (uint64_t*)malloc(sizeof(uint64_t) * ChunkSize);
+            if (c->long_length == NULL)
+                return false;
         }
-      }
+        c->long_length[off] = len;
+        c->length[off] = LongLength;
+    }
+    else{
+        c->length[off] = (uint32_t)len;
+    }
+
+    c->res_index[off] = resIndex;
+
+    update_index(start, end);
+
+    // Publish it to the readers
+    _item_count.store(dex + 1, std::memory_order_release);
+
+    // Only the writer changes them, the readers load them any time
+    if (len > _max_annotation.load(std::memory_order_relaxed))
+        _max_annotation.store(len, std::memory_order_relaxed);
+
+    if (len != 0){
+        const uint64_t min_len = _min_annotation.load(std::memory_order_relaxed);
+        if (min_len == 0 || len < min_len)
+            _min_annotation.store(len, std::memory_order_relaxed);
+    }
           
-      return true;
-      
-    } catch (const std::bad_alloc&) {
-      return false;
+    return true;
+}
+
+// Called by the writer, o has no reader
+bool RowData::append(RowData &o)
+{
+    assert(&o != this);
+
+    const ChunkTable *table = o._table.load(std::memory_order_relaxed);
+    const uint64_t count = o._item_count.load(std::memory_order_relaxed);
+    bool ret = true;
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        uint64_t start = get_start(table, i);
+        uint64_t end = get_end(table, i, start);
+
+        if (!push_annotation_self(start, end, get_res_index(table, i))){
+            ret = false;
+            break;
+        }
     }
+
+    o.clear();
+    return ret;
 }
- 
 
 bool RowData::get_annotation(Annotation *ann, uint64_t index)
 {
     assert(ann);
 
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
+    ReadScope rd(this);
 
-    if (index < _annotations.size()) {
-        *ann = *_annotations[index]; //clone
+    if (index < rd.count) {
+        uint64_t start = get_start(rd.table, index);
+        uint64_t end = get_end(rd.table, index, start);
+        *ann = Annotation(start, end, get_res_index(rd.table, index), _status);
         return true;
     } else {
         return false;
@@ -24,18 +24,91 @@
 #define DSVIEW_PV_DATA_DECODE_ROWDATA_H
 
 #include <vector> 
-#include <mutex>
+#include <atomic>
 
 #include "annotation.h"
 
+class DecoderStatus;
+
 namespace pv {
 namespace data {
 namespace decode {
 
+// Written by the decode thread only, read by any thread without lock.
+// The writer publishes the annotation count after the data,
+// and clear() waits until the readers leave before releasing the chunks.
+// Other threads call clear() only after the decode task has ended.
 class RowData
 {
+private:
+    // Annotations are indexed in blocks of push order
+    static const uint64_t IndexBlockSize = 1024;
+
+    // Annotations are stored in chunks of push order, a multiple of IndexBlockSize
+    static const uint64_t ChunkSize = 4096;
+    static const uint64_t ChunkBlocks = ChunkSize / IndexBlockSize;
+
+    // The values out of the 32 bits range are kept in the side arrays of the chunk
+    static const int32_t  FarStart = INT32_MIN;
+    static const uint32_t LongLength = UINT32_MAX;
+
+    // A bound that the writer widens while the readers visit it
+    struct IndexBound
+    {
+        std::atomic<uint64_t> value;
+
+        inline uint64_t get() const{
+            return value.load(std::memory_order_relaxed);
+        }
+        inline void set(uint64_t v){
+            value.store(v, std::memory_order_relaxed);
+        }
+    };
+
+    struct IndexBlock
+    {
+        IndexBound  min_start;
+        IndexBound  max_end;
+        IndexBound  pre_max_start; // of this and all previous blocks
+        IndexBound  pre_max_end;   // of this and all previous blocks
+        IndexBound  suf_min_start; // of this and all next blocks
+    };
+
+    // 12 bytes for each annotation
+    struct AnnotationChunk
+    {
+        uint64_t    base;                   // start sample of the first annotation
+        uint64_t    *far_start;             // created by the first far start
+        uint64_t    *long_length;           // created by the first long length
+        IndexBlock  index[ChunkBlocks];
+        int32_t     start_delta[ChunkSize]; // start sample - base
+        uint32_t    length[ChunkSize];      // end sample - start sample
+        int32_t     res_index[ChunkSize];
+    };
+
+    // The chunk list seen by the readers, replaced when it is full
+    struct ChunkTable
+    {
+        uint64_t        capacity;
+        AnnotationChunk *chunks[1];
+    };
+
+    // Keeps the chunks alive while a reader visits them
+    class ReadScope
+    {
+    public:
+        ReadScope(RowData *row);
+        ~ReadScope();
+
+        uint64_t          count;
+        const ChunkTable  *table;
+
+    private:
+        RowData *_row;
+    };
+
 public:
-	RowData();
+	RowData(DecoderStatus *status);
     ~RowData();
 
 public:
@@ -46,10 +119,13 @@ public:
 
     uint64_t get_annotation_index(uint64_t start_sample);
 
-    bool push_annotation(Annotation *a);
+    bool push_annotation(const Annotation &a);
+
+    // Move all annotations of o to the end of this row
+    bool append(RowData &o);
 
     inline uint64_t get_annotation_size(){
-        return _item_count;
+        return _item_count.load(std::memory_order_acquire);
     }
 
     bool get_annotation(pv::data::decode::Annotation *ann, uint64_t index);
@@ -57,17 +133,35 @@ public:
      /**
 	 * Extracts sorted annotations between two period into a vector.
 	 */
-	void get_annotation_subset(std::vector<pv::data::decode::Annotation*> &dest,
+	void get_annotation_subset(std::vector<pv::data::decode::Annotation> &dest,
 		                        uint64_t start_sample, uint64_t end_sample);
 
     void clear();
 
 private:
-    uint64_t        _max_annotation;
-    uint64_t        _min_annotation;
-    uint64_t        _item_count;
-	std::vector<Annotation*> _annotations;
-    static std::mutex _global_visitor_mutex;
+    void update_index(uint64_t start, uint64_t end);
+    bool push_annotation_self(uint64_t start, uint64_t end, int resIndex);
+    bool add_chunk_self(uint64_t start);
+
+    static IndexBlock* get_block(const ChunkTable *table, uint64_t block);
+
+    // The first block in [first, last) that pred is false for
+    template<class Pred>
+    static uint64_t partition_block(const ChunkTable *table, uint64_t first,
+                                    uint64_t last, Pred pred);
+    static uint64_t get_start(const ChunkTable *table, uint64_t index);
+    static uint64_t get_end(const ChunkTable *table, uint64_t index, uint64_t start);
+    static int get_res_index(const ChunkTable *table, uint64_t index);
+
+private:
+    DecoderStatus   *_status;
+    std::atomic<uint64_t>       _max_annotation;
+    std::atomic<uint64_t>       _min_annotation;
+    uint64_t        _chunk_count; // of the writer, a chunk may be not published
+    std::atomic<uint64_t>       _item_count;
+    std::atomic<ChunkTable*>    _table;
+    std::atomic<int>            _readers;
+    std::vector<ChunkTable*>    _retired_tables;
 };
 
 }
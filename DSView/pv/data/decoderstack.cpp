@@ -35,7 +35,9 @@
 #include "../dsvdef.h"
 #include "../log.h"
 #include "../ui/langresource.h"
+#include "../config/appconfig.h"
 #include <ds_types.h>
+#include <thread>
 
 using namespace pv::data::decode;
 using namespace std;
@@ -164,7 +166,7 @@ void DecoderStack::build_row()
         // Add a row for the decoder if it doesn't have a row list
         if (!decc->annotation_rows) {
             const Row row(decc);
-            _rows[row] = new decode::RowData();
+            _rows[row] = new decode::RowData(_decoder_status);
             std::map<const decode::Row, bool>::const_iterator iter = _rows_gshow.find(row);
             if (iter == _rows_gshow.end()) {
                 _rows_gshow[row] = true;
@@ -188,7 +190,7 @@ void DecoderStack::build_row()
             const Row row(decc, ann_row, order);
 
             // Add a new empty row data object
-            _rows[row] = new decode::RowData();
+            _rows[row] = new decode::RowData(_decoder_status);
             std::map<const decode::Row, bool>::const_iterator iter = _rows_gshow.find(row);
             if (iter == _rows_gshow.end()) {
                 _rows_gshow[row] = true;
@@ -217,7 +219,7 @@ int64_t DecoderStack::samples_decoded()
 }
 
 void DecoderStack::get_annotation_subset(
-	std::vector<pv::data::decode::Annotation*> &dest,
+	std::vector<pv::data::decode::Annotation> &dest,
 	const Row &row, uint64_t start_sample,
 	uint64_t end_sample)
 {  
@@ -506,18 +508,7 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
     //uint8_t *chunk = NULL;
     uint64_t last_cnt = 0;
     uint64_t notify_cnt = (decode_end - decode_start + 1)/100;
-    srd_decoder_inst *logic_di = NULL;
-
-    // find the first level decoder instant
-    for (GSList *d = session->di_list; d; d = d->next) {
-        srd_decoder_inst *di = (srd_decoder_inst *)d->data;
-        srd_decoder *decoder = di->decoder;
-        const bool have_probes = (decoder->channels || decoder->opt_channels) != 0;
-        if (have_probes) {
-            logic_di = di;
-            break;
-        }
-    }
+    srd_decoder_inst *logic_di = get_logic_decoder_inst(session);
 
     assert(logic_di);
 
@@ -530,26 +521,35 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
         dsv_info("decode data index have been to end");
     }
 
-    std::vector<const uint8_t *> chunk;
-    std::vector<uint8_t> chunk_const;
+    const int ch_num = logic_di->dec_num_channels;
+    std::vector<const uint8_t *> chunk(ch_num);
+    std::vector<uint8_t> chunk_const(ch_num);
+    std::vector<void*> chunk_lbp(ch_num);
     bool bCheckEnd = false;
     uint64_t end_index = decode_end;
     uint64_t decoded_sample_count = 0;
 
+    for (int j =0 ; j < ch_num; j++) {
+        int sig_index = logic_di->dec_channelmap[j];
+
+        if (sig_index != -1 && !_snapshot->has_data(sig_index)) {
+            _error_message = L_S(STR_PAGE_MSG, S_ID(IDS_MSG_DECODERSTACK_DECODE_DATA_ERROR),
+                                "At least one of selected channels are not enabled.");
+            return;
+        }
+    }
+
     _progress = 0;
     _is_decoding = true;
 
     void* lbp_array[35];
 
-    for (int j =0 ; j < logic_di->dec_num_channels; j++){
+    for (int j =0 ; j < ch_num; j++){
         lbp_array[j] = NULL;
     }
 
     while(i <= end_index && !_no_memory && !status->_bStop)
     {
-        chunk.clear();
-        chunk_const.clear();
-
         if (_is_capture_end)
         {
             if (!bCheckEnd){
@@ -581,36 +581,23 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
             continue;
         }
  
-        uint64_t chunk_end = end_index;
+        // The span of all channels with one lock
+        uint64_t chunk_end = _snapshot->get_decode_span(i, end_index, logic_di->dec_channelmap,
+                                ch_num, chunk.data(), chunk_const.data(), chunk_lbp.data());
+        bool bFlat = true;
 
-        for (int j =0 ; j < logic_di->dec_num_channels; j++) {
-            int sig_index = logic_di->dec_channelmap[j];
-            void *lbp = NULL;
-
-            if (sig_index == -1) {
-                chunk.push_back(NULL);
-                chunk_const.push_back(0);
-            }
-            else {
-                if (_snapshot->has_data(sig_index)) {
-                    const uint8_t *data_ptr = _snapshot->get_samples(i, chunk_end, sig_index, &lbp);
-                    bool flag = _snapshot->get_sample(i, sig_index);
-                    chunk.push_back(data_ptr);
-                    chunk_const.push_back(flag);
-
-                    if (_snapshot->is_able_free() == false)
-                    {
-                        if (lbp_array[j] != lbp){
-                            if (lbp_array[j] != NULL)
-                                _snapshot->free_decode_lpb(lbp_array[j]);
-                            lbp_array[j] = lbp;
-                        }
-                    }
-                }
-                else {
-                    _error_message = L_S(STR_PAGE_MSG, S_ID(IDS_MSG_DECODERSTACK_DECODE_DATA_ERROR),
-                                     "At least one of selected channels are not enabled.");
-                    return;
+        for (int j =0 ; j < ch_num; j++)
+        {
+            if (chunk[j] != NULL)
+                bFlat = false;
+
+            if (_snapshot->is_able_free() == false)
+            {
+                void *lbp = chunk_lbp[j];
+                if (lbp_array[j] != lbp){
+                    if (lbp_array[j] != NULL)
+                        _snapshot->free_decode_lpb(lbp_array[j]);
+                    lbp_array[j] = lbp;
                 }
             }
         }
@@ -621,10 +608,11 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
             break;
         }
 
-        if (chunk_end >= end_index)
-            chunk_end = end_index + 1;
-        if (chunk_end - i > MaxChunkSize)
+        // The flat span is matched by the levels, send it in large pieces
+        if (!bFlat && chunk_end - i > MaxChunkSize)
             chunk_end = i + MaxChunkSize;
+        else if (chunk_end - i > MaxFlatChunkSize)
+            chunk_end = i + MaxFlatChunkSize;
 
         bEndTime = (chunk_end > end_index);
 
@@ -690,28 +678,18 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
     dsv_info("Decoded sample count:%llu", decoded_sample_count);
 }
 
-void DecoderStack::execute_decode_stack()
-{  
+srd_session* DecoderStack::create_decode_session(srd_pd_output_callback cb, void *cb_data)
+{
 	srd_session *session = NULL;
 	srd_decoder_inst *prev_di = NULL;
-    uint64_t decode_start = 0;
-    uint64_t decode_end = 0;
 
-	assert(_snapshot);
-
-	// Create the session
-    // one decoderstatck onwer one session
-    // all decoderstatck execute in sequence
 	srd_session_new(&session);
 
     if (session == NULL){
         dsv_err("Failed to call srd_session_new()");
         assert(false);
     }
-    
-    // Get the intial sample count
-    _sample_count = _snapshot->get_ring_sample_count();
- 
+
     // Create the decoders
     for(auto dec : _stack)
 	{
@@ -722,13 +700,46 @@ void DecoderStack::execute_decode_stack()
 			_error_message =L_S(STR_PAGE_MSG, S_ID(IDS_MSG_DECODERSTACK_DECODE_STACK_ERROR), 
                             "Failed to create decoder instance");
 			srd_session_destroy(session);
-			return;
+			return NULL;
 		}
 
 		if (prev_di)
 			srd_inst_stack (session, prev_di, di);
 
 		prev_di = di;
+	}
+
+	srd_session_metadata_set(session, SRD_CONF_SAMPLERATE,
+		g_variant_new_uint64((uint64_t)_samplerate));
+
+	srd_pd_output_callback_add(session, SRD_OUTPUT_ANN, cb, cb_data);
+
+    // Start the session
+    char *error = NULL;
+    if (srd_session_start(session, &error) != SRD_OK){
+        if (error != NULL){
+            _error_message = QString::fromLocal8Bit(error);
+            g_free(error);
+        }
+        srd_session_destroy(session);
+        return NULL;
+    }
+
+    return session;
+}
+
+void DecoderStack::execute_decode_stack()
+{
+    uint64_t decode_start = 0;
+    uint64_t decode_end = 0;
+
+	assert(_snapshot);
+
+    // Get the intial sample count
+    _sample_count = _snapshot->get_ring_sample_count();
+
+    for(auto dec : _stack)
+	{
         decode_start = dec->decode_start();
 
         if (_session->is_realtime_refresh() == false)
@@ -740,31 +751,286 @@ void DecoderStack::execute_decode_stack()
     dsv_info("Decode start sample index:%llu, end sample index:%llu, count:%llu", 
             (u64_t)decode_start, (u64_t)decode_end, (u64_t)(decode_end - decode_start + 1));
 
-	// Start the session
-	srd_session_metadata_set(session, SRD_CONF_SAMPLERATE,
-		g_variant_new_uint64((uint64_t)_samplerate));
+    std::vector<decode_segment*> segments;
 
-	srd_pd_output_callback_add(
-                    session, 
-                    SRD_OUTPUT_ANN,
-		            DecoderStack::annotation_callback,
-                    _stask_stauts);
+    if (make_decode_segments(decode_start, decode_end, segments)){
+        execute_decode_segments(segments);
 
-    char *error = NULL;
-    if (srd_session_start(session, &error) == SRD_OK){
-       //need a lot time
+        for (auto seg : segments){
+            delete seg;
+        }
+        return;
+    }
+
+	// Create the session
+    // one decoderstatck onwer one session
+	srd_session *session = create_decode_session(DecoderStack::annotation_callback, _stask_stauts);
+
+    if (session != NULL){
+        //need a lot time
         decode_data(decode_start, decode_end, session);
+        srd_session_destroy(session);
     }
-    else if (error != NULL){
-        _error_message = QString::fromLocal8Bit(error);
+}
+
+// Cut the decode range at the idle gaps of the bound channels,
+// so the segments can be decoded by their own sessions at the same time.
+bool DecoderStack::make_decode_segments(uint64_t decode_start, uint64_t decode_end,
+                        std::vector<decode_segment*> &segments)
+{
+    // A single decoder resyncs at an idle gap,
+    // the stacked decoders keep the state of the whole stream.
+    if (!AppConfig::Instance().appOptions.segmentDecode
+        || _stack.size() != 1
+        || _session->is_realtime_refresh()
+        || !_is_capture_end
+        || !_snapshot->is_able_free()
+        || decode_end <= decode_start){
+        return false;
     }
 
-	// Destroy the session
-    if (error != NULL) {
-        g_free(error);
+    const uint64_t total = decode_end - decode_start + 1;
+    uint64_t num = min((uint64_t)_session->get_decode_worker_max(), total / MinSegmentSamples);
+
+    if (num < 2){
+        return false;
+    }
+
+    std::vector<int> sig_indexs;
+    decode::Decoder *dec = _stack.front();
+
+    for (auto ch : dec->binded_probe_list()){
+        int sig_index = dec->binded_probe_index(ch);
+        if (!_snapshot->has_data(sig_index)){
+            return false;
+        }
+        sig_indexs.push_back(sig_index);
+    }
+
+    // The lines must stay idle much longer than a symbol of the protocol
+    const uint64_t min_gap = max((uint64_t)(_samplerate / 100), (uint64_t)MinIdleGapSamples);
+    const uint64_t seg_len = total / num;
+    uint64_t last_cut = decode_start;
+    std::vector<std::pair<uint64_t, uint64_t> > cuts; // gap start, cut index
+
+    for (uint64_t k = 1; k < num; k++)
+    {
+        uint64_t index = max(decode_start + k * seg_len, last_cut + MinSegmentSamples);
+        uint64_t search_end = min(index + seg_len / 2, decode_end);
+
+        if (index >= search_end){
+            break;
+        }
+
+        if (_snapshot->find_idle_gap(index, search_end, min_gap, sig_indexs)){
+            last_cut = index + min_gap / 2;
+            cuts.push_back(std::make_pair(index, last_cut));
+        }
+    }
+
+    if (cuts.empty()){
+        dsv_info("No idle gap to segment the decoding.");
+        return false;
+    }
+
+    // Each segment starts at the beginning of the gap to see the idle level,
+    // and keeps only the annotations after the cut.
+    for (int k = 0; k <= (int)cuts.size(); k++)
+    {
+        decode_segment *seg = new decode_segment();
+        seg->_status = _stask_stauts;
+        seg->_start = (k == 0) ? decode_start : cuts[k-1].first;
+        seg->_keep_start = (k == 0) ? decode_start : cuts[k-1].second;
+        seg->_is_first = (k == 0);
+        seg->_is_last = (k == (int)cuts.size());
+        seg->_end = seg->_is_last ? decode_end : cuts[k].second - 1;
+        seg->_decoded = 0;
+        seg->_done = false;
+        seg->_session = NULL;
+        segments.push_back(seg);
+    }
+
+    dsv_info("Decode in %d segments.", (int)segments.size());
+
+    return true;
+}
+
+void DecoderStack::execute_decode_segments(std::vector<decode_segment*> &segments)
+{
+    decode_task_status *status = _stask_stauts;
+    std::vector<std::thread> threads;
+    uint64_t total = 0;
+    bool bReady = true;
+
+    // The python objects are created one by one in this thread
+    for (auto seg : segments)
+    {
+        seg->_session = create_decode_session(DecoderStack::segment_annotation_callback, seg);
+        if (seg->_session == NULL){
+            bReady = false;
+            break;
+        }
+        total += seg->_end - seg->_start + 1;
+    }
+
+    if (bReady)
+    {
+        _progress = 0;
+        _is_decoding = true;
+
+        for (auto seg : segments){
+            threads.push_back(std::thread(&DecoderStack::decode_segment_data, this, seg));
+        }
+
+        int done_num = 0;
+
+        while (done_num < (int)segments.size())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            uint64_t decoded = 0;
+            done_num = 0;
+
+            for (auto seg : segments){
+                decoded += seg->_decoded;
+                if (seg->_done)
+                    done_num++;
+            }
+
+            _progress = (int)(decoded * 100 / total);
+
+            //use mutex
+            {
+                std::lock_guard<std::mutex> lock(_output_mutex);
+                _samples_decoded = segments.front()->_decoded;
+            }
+
+            new_decode_data();
+        }
+
+        for (auto &th : threads){
+            th.join();
+        }
+
+        // Stitch the results in order, the first segment is already in the rows
+        for (auto seg : segments)
+        {
+            for (auto &r : seg->_rows)
+            {
+                if (!status->_bStop && !_no_memory && !r.first->append(*r.second)){
+                    _no_memory = true;
+                }
+                delete r.second;
+            }
+            seg->_rows.clear();
+
+            if (seg->_error != "" && _error_message == "")
+                _error_message = seg->_error;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_output_mutex);
+            _samples_decoded = segments.back()->_end - segments.front()->_start + 1;
+        }
+
+        _progress = 100;
+        _is_decoding = false;
+
+        new_decode_data();
+
+        if (!_session->is_closed()){
+            decode_done();
+        }
+    }
+
+    for (auto seg : segments){
+        if (seg->_session != NULL)
+            srd_session_destroy(seg->_session);
+    }
+}
+
+// the segment decode thread proc
+void DecoderStack::decode_segment_data(decode_segment *seg)
+{
+    decode_task_status *status = seg->_status;
+    srd_decoder_inst *logic_di = get_logic_decoder_inst(seg->_session);
+    uint64_t i = seg->_start;
+    char *error = NULL;
+    bool bError = false;
+
+    assert(logic_di);
+
+    const int ch_num = logic_di->dec_num_channels;
+    std::vector<const uint8_t *> chunk(ch_num);
+    std::vector<uint8_t> chunk_const(ch_num);
+
+    while (i <= seg->_end && !_no_memory && !status->_bStop)
+    {
+        uint64_t chunk_end = _snapshot->get_decode_span(i, seg->_end, logic_di->dec_channelmap,
+                                ch_num, chunk.data(), chunk_const.data(), NULL);
+        bool bFlat = true;
+
+        for (int j =0 ; j < ch_num; j++){
+            if (chunk[j] != NULL)
+                bFlat = false;
+        }
+
+        if (!bFlat && chunk_end - i > MaxChunkSize)
+            chunk_end = i + MaxChunkSize;
+        else if (chunk_end - i > MaxFlatChunkSize)
+            chunk_end = i + MaxFlatChunkSize;
+
+        if (srd_session_send(
+                seg->_session,
+                i,
+                chunk_end,
+                chunk.data(),
+                chunk_const.data(),
+                chunk_end - i,
+                &error) != SRD_OK){
+
+            if (error){
+                seg->_error = QString::fromLocal8Bit(error);
+                dsv_err("ERROR: Failed to call srd_session_send:%s", error);
+                g_free(error);
+                error = NULL;
+            }
+
+            bError = true;
+            break;
+        }
+
+        seg->_decoded += chunk_end - i;
+        i = chunk_end;
     }
 
-	srd_session_destroy(session); 
+    // Only the last segment reaches the end of the data
+    if (seg->_is_last && !bError && i > seg->_end && !status->_bStop){
+        srd_session_end(seg->_session, &error);
+
+        if (error != NULL){
+            seg->_error = QString::fromLocal8Bit(error);
+            dsv_err("Failed to call srd_session_end:%s", error);
+            g_free(error);
+        }
+    }
+
+    seg->_done = true;
+}
+
+srd_decoder_inst* DecoderStack::get_logic_decoder_inst(srd_session *session)
+{
+    // find the first level decoder instant
+    for (GSList *d = session->di_list; d; d = d->next) {
+        srd_decoder_inst *di = (srd_decoder_inst *)d->data;
+        srd_decoder *decoder = di->decoder;
+        const bool have_probes = (decoder->channels || decoder->opt_channels) != 0;
+        if (have_probes) {
+            return di;
+        }
+    }
+
+    return NULL;
 }
 
 uint64_t DecoderStack::sample_count()
@@ -803,42 +1069,97 @@ void DecoderStack::annotation_callback(srd_proto_data *pdata, void *self)
         return;
     }
 
-    Annotation *a = new Annotation(pdata, d->_decoder_status);
-    if (a == NULL){
-        d->_no_memory = true;
-        return;     
+    Annotation a(pdata, d->_decoder_status);
+    d->_result_count++;
+
+    RowData *row = d->get_annotation_row(pdata, a.format());
+    if (row == NULL){
+        return;
+    }
+
+	// Add the annotation 
+    if (!row->push_annotation(a))
+        d->_no_memory = true; 
+}
+
+//the decode callback of a segment, the results are kept until all segments end
+void DecoderStack::segment_annotation_callback(srd_proto_data *pdata, void *self)
+{
+    assert(pdata);
+	assert(self);
+
+    decode_segment *seg = (decode_segment*)self;
+    DecoderStack *const d = seg->_status->_decoder;
+	assert(d);
+
+    if (seg->_status->_bStop || d->_no_memory){ 
+        return;
     }
+
+    // The previous segment has decoded it
+    if (pdata->start_sample < seg->_keep_start){
+        return;
+    }
+
+    // The callback runs without the GIL, so the segments meet here
+    std::unique_lock<std::mutex> res_lock(d->_res_mutex);
+    Annotation a(pdata, d->_decoder_status);
+    res_lock.unlock();
     d->_result_count++;
 
+    RowData *row = d->get_annotation_row(pdata, a.format());
+    if (row == NULL){
+        return;
+    }
+
+    if (!seg->_is_first)
+    {
+        auto it = seg->_rows.find(row);
+
+        if (it == seg->_rows.end()){
+            try {
+                it = seg->_rows.insert(std::make_pair(row, new RowData(d->_decoder_status))).first;
+            } catch (const std::bad_alloc&) {
+                d->_no_memory = true;
+                return;
+            }
+        }
+        row = (*it).second;
+    }
+
+    if (!row->push_annotation(a))
+        d->_no_memory = true;
+}
+
+RowData* DecoderStack::get_annotation_row(srd_proto_data *pdata, int format)
+{
 	// Find the row
 	assert(pdata->pdo);
 	assert(pdata->pdo->di);
 	const srd_decoder *const decc = pdata->pdo->di->decoder;
 	assert(decc);
 
-    auto row_iter = d->_rows.end();
+    auto row_iter = _rows.end();
 	
 	// Try looking up the sub-row of this class
 	const map<pair<const srd_decoder*, int>, Row>::const_iterator r =
-        d->_class_rows.find(make_pair(decc, a->format()));
-	if (r != d->_class_rows.end())
-        row_iter = d->_rows.find((*r).second);
+        _class_rows.find(make_pair(decc, format));
+	if (r != _class_rows.end())
+        row_iter = _rows.find((*r).second);
 	else
 	{
 		// Failing that, use the decoder as a key
-        row_iter = d->_rows.find(Row(decc));
+        row_iter = _rows.find(Row(decc));
 	}
 
-    assert(row_iter != d->_rows.end());
-    if (row_iter == d->_rows.end()) {
-        dsv_err("Unexpected annotation: decoder = 0x%x, format = %d", (void*)decc, a->format());
+    assert(row_iter != _rows.end());
+    if (row_iter == _rows.end()) {
+        dsv_err("Unexpected annotation: decoder = 0x%x, format = %d", (void*)decc, format);
         assert(0);
-        return;
+        return NULL;
     }
 
-	// Add the annotation 
-    if (!(*row_iter).second->push_annotation(a))
-        d->_no_memory = true; 
+    return (*row_iter).second;
 }
  
 void DecoderStack::frame_ended()
@@ -29,6 +29,8 @@
 #include <QObject>
 #include <QString>
 #include <mutex> 
+#include <vector>
+#include <atomic>
 
 #include "decode/row.h" 
 #include "../data/signaldata.h"
@@ -65,6 +67,22 @@ struct decode_task_status
     DecoderStack *_decoder;
 };
 
+// A part of the decode range, decoded by its own session
+struct decode_segment
+{
+    decode_task_status  *_status;
+    uint64_t            _start;      // the first sample sent to decoder
+    uint64_t            _keep_start; // the annotations start before it are dropped
+    uint64_t            _end;        // the last sample sent to decoder
+    volatile uint64_t   _decoded;
+    volatile bool       _done;
+    bool                _is_first;   // the results go to the rows directly
+    bool                _is_last;
+    srd_session         *_session;
+    QString             _error;
+    std::map<decode::RowData*, decode::RowData*> _rows; // target row, results
+};
+
  //a torotocol have a DecoderStack, destroy by DecodeTrace
 class DecoderStack : public QObject, public SignalData
 {
@@ -76,6 +94,9 @@ private:
 	static const int64_t DecodeChunkLength;
 	static const unsigned int DecodeNotifyPeriod;
     static const uint64_t MaxChunkSize = 1024 * 16;
+    static const uint64_t MaxFlatChunkSize = 1ULL << 26; // the levels only, matched in C
+    static const uint64_t MinSegmentSamples = 1ULL << 24;
+    static const uint64_t MinIdleGapSamples = 1ULL << 16;
 
 public:
     enum decode_state {
@@ -109,7 +130,7 @@ public:
 	 * Extracts sorted annotations between two period into a vector.
 	 */
 	void get_annotation_subset(
-		std::vector<pv::data::decode::Annotation*> &dest,
+		std::vector<pv::data::decode::Annotation> &dest,
 		const decode::Row &row, uint64_t start_sample,
 		uint64_t end_sample);
 
@@ -191,6 +212,15 @@ private:
     void decode_data(const uint64_t decode_start, const uint64_t decode_end, srd_session *const session);
 	void execute_decode_stack();
 	static void annotation_callback(srd_proto_data *pdata, void *self);
+    static void segment_annotation_callback(srd_proto_data *pdata, void *self);
+    decode::RowData* get_annotation_row(srd_proto_data *pdata, int format);
+    srd_decoder_inst* get_logic_decoder_inst(srd_session *session);
+    srd_session* create_decode_session(srd_pd_output_callback cb, void *cb_data);
+
+    bool make_decode_segments(uint64_t decode_start, uint64_t decode_end,
+                        std::vector<decode_segment*> &segments);
+    void execute_decode_segments(std::vector<decode_segment*> &segments);
+    void decode_segment_data(decode_segment *seg);
     void do_decode_work();
   
 signals:
@@ -219,10 +249,11 @@ private:
  
     decode_task_status  *_stask_stauts;    
     mutable std::mutex _output_mutex; 
+    std::mutex      _res_mutex; // the segment threads share the res table
     bool            _is_capture_end;
     int             _progress;
     bool            _is_decoding;
-    uint64_t        _result_count;
+    std::atomic<uint64_t> _result_count;
 
 	friend class DecoderStackTest::TwoDecoderStack;
 };
@@ -0,0 +1,241 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2022 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "dsopersistence.h"
+#include <math.h>
+#include <algorithm>
+#include "samplekernel.h"
+
+using namespace std;
+
+namespace pv {
+namespace data {
+
+const float DsoPersistence::RenormalizeWeight = 1e4f;
+
+DsoPersistence::DsoPersistence() :
+    _thread_exit(false),
+    _clear(false),
+    _decay_frames(DefaultDecayFrames),
+    _generation(0)
+{
+    reset_histogram(_work);
+    reset_histogram(_shown);
+}
+
+DsoPersistence::~DsoPersistence()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _thread_exit = true;
+    }
+    _cond.notify_one();
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void DsoPersistence::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    clear_unlock();
+}
+
+void DsoPersistence::clear_unlock()
+{
+    while (!_pending.empty()) {
+        _free_frames.push_back(std::move(_pending.front()));
+        _pending.pop_front();
+    }
+    // The worker may be folding a frame, it drops the histogram after it
+    _clear = true;
+    reset_histogram(_shown);
+    _generation++;
+}
+
+void DsoPersistence::reset_histogram(Histogram &h)
+{
+    h.hits.clear();
+    h.columns = 0;
+    h.group_size = 1;
+    h.samples = 0;
+    h.weight = 1;
+    h.max_hits = 0;
+}
+
+void DsoPersistence::set_decay_frames(int frames)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _decay_frames = max(frames, 0);
+}
+
+void DsoPersistence::append_frame(const uint8_t *samples, uint64_t count)
+{
+    if (samples == NULL || count == 0)
+        return;
+
+    // A column takes a whole number of samples, the remainder is dropped
+    const int group_size = (int)max((count + Columns - 1) / Columns, (uint64_t)1);
+    const int columns = (int)(count / group_size);
+
+    Frame frame;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_free_frames.empty()) {
+            frame = std::move(_free_frames.back());
+            _free_frames.pop_back();
+        }
+    }
+
+    frame.envelope.resize(columns * 2);
+    frame.columns = columns;
+    frame.group_size = group_size;
+    frame.samples = count;
+    envelope_contiguous(samples, columns, group_size, frame.envelope.data());
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // The display is late, the oldest frame is the least visible one
+        if ((int)_pending.size() >= MaxPendingFrames) {
+            _free_frames.push_back(std::move(_pending.front()));
+            _pending.pop_front();
+        }
+        _pending.push_back(std::move(frame));
+
+        if (!_thread.joinable())
+            _thread = std::thread(&DsoPersistence::accumulate_proc, this);
+    }
+    _cond.notify_one();
+}
+
+bool DsoPersistence::get_histogram(std::vector<float> &hits, int &columns,
+                                   uint64_t &samples, float &norm, float &max_hits)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_shown.columns == 0 || _shown.max_hits <= 0)
+        return false;
+
+    hits.assign(_shown.hits.begin(), _shown.hits.end());
+    columns = _shown.columns;
+    samples = (uint64_t)_shown.columns * _shown.group_size;
+    norm = _shown.weight;
+    max_hits = _shown.max_hits;
+    return true;
+}
+
+uint64_t DsoPersistence::get_generation()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _generation;
+}
+
+void DsoPersistence::accumulate_proc()
+{
+    Frame frame;
+
+    while (true) {
+        int decay_frames;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (frame.envelope.capacity() > 0)
+                _free_frames.push_back(std::move(frame));
+
+            _cond.wait(lock, [this]{ return _thread_exit || !_pending.empty(); });
+            if (_thread_exit)
+                break;
+
+            frame = std::move(_pending.front());
+            _pending.pop_front();
+            decay_frames = _decay_frames;
+
+            // Cleared since the last frame, the frame starts a new histogram
+            if (_clear)
+                reset_histogram(_work);
+            _clear = false;
+        }
+
+        // The session appends the next frames meanwhile
+        accumulate(frame, decay_frames);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Cleared while the frame was folded, it belongs to the old histogram
+        if (_clear)
+            continue;
+
+        _shown.hits.assign(_work.hits.begin(), _work.hits.end());
+        _shown.columns = _work.columns;
+        _shown.group_size = _work.group_size;
+        _shown.samples = _work.samples;
+        _shown.weight = _work.weight;
+        _shown.max_hits = _work.max_hits;
+        _generation++;
+    }
+}
+
+void DsoPersistence::accumulate(const Frame &frame, int decay_frames)
+{
+    Histogram &h = _work;
+
+    if (frame.columns != h.columns || frame.samples != h.samples) {
+        h.hits.assign((size_t)frame.columns * Levels, 0);
+        h.columns = frame.columns;
+        h.group_size = frame.group_size;
+        h.samples = frame.samples;
+        h.weight = 1;
+        h.max_hits = 0;
+    }
+
+    /*
+     * Instead of multiplying the whole histogram by the decay on each frame,
+     * the new hits weigh 1/decay more than the ones of the previous frame.
+     * The histogram is scaled back once in a while, a frame only touches its spans.
+     */
+    if (decay_frames > 0) {
+        h.weight *= (float)exp(1.0 / decay_frames);
+        if (h.weight > RenormalizeWeight) {
+            hits_scale(h.hits.data(), h.hits.size(), 1.0f / h.weight, 1e-6f);
+            h.max_hits /= h.weight;
+            h.weight = 1;
+        }
+    }
+
+    const uint8_t *const e = frame.envelope.data();
+    float *const hits = h.hits.data();
+
+    for (int col = 0; col < frame.columns; col++) {
+        int lo = e[2*col];
+        int hi = e[2*col + 1];
+
+        // Overlap with the next column, the steep edges have no gap
+        if (col + 1 < frame.columns) {
+            lo = min(lo, (int)e[2*col + 3]);
+            hi = max(hi, (int)e[2*col + 2]);
+        }
+
+        const float mx = hits_add(hits + (size_t)col * Levels + lo, hi - lo + 1, h.weight);
+        h.max_hits = max(h.max_hits, mx);
+    }
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2022 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef DSVIEW_PV_DATA_DSOPERSISTENCE_H
+#define DSVIEW_PV_DATA_DSOPERSISTENCE_H
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace pv {
+namespace data {
+
+//The hit count of the frames of one dso channel, time x voltage.
+//The session hands the frames over, a worker thread accumulates them,
+//so the older frames fade out behind the last one.
+class DsoPersistence
+{
+public:
+    static const int Columns = 1024;
+    static const int Levels = 256;
+    static const int DefaultDecayFrames = 32;
+
+private:
+    static const int MaxPendingFrames = 16;
+    // The weights are scaled back before the floats lose the old hits
+    static const float RenormalizeWeight;
+
+    struct Frame
+    {
+        std::vector<uint8_t> envelope;  // {min, max} of each column
+        int columns;
+        int group_size;
+        uint64_t samples;
+    };
+
+    struct Histogram
+    {
+        std::vector<float> hits;
+        int columns;
+        int group_size;
+        uint64_t samples;
+        float weight;
+        float max_hits;
+    };
+
+public:
+    DsoPersistence();
+    ~DsoPersistence();
+
+    void clear();
+
+    // A hit fades to 1/e after this many frames, 0 keeps all of them
+    void set_decay_frames(int frames);
+
+    inline int get_decay_frames(){
+        return _decay_frames;
+    }
+
+    /*
+     * Takes the column envelope of a whole frame, the histogram is updated later.
+     * A frame of another length starts the histogram again.
+     */
+    void append_frame(const uint8_t *samples, uint64_t count);
+
+    /*
+     * Copies the histogram, Levels values per column, and its scale.
+     * hits[col * Levels + value] / norm is the decayed hit count,
+     * the columns cover the first samples of the frames.
+     * Returns false if no frame was accumulated.
+     */
+    bool get_histogram(std::vector<float> &hits, int &columns,
+                       uint64_t &samples, float &norm, float &max_hits);
+
+    // Changes with each accumulated frame
+    uint64_t get_generation();
+
+private:
+    void accumulate_proc();
+    void accumulate(const Frame &frame, int decay_frames);
+    void clear_unlock();
+    static void reset_histogram(Histogram &h);
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::thread _thread;
+    bool _thread_exit;
+    bool _clear;
+    int _decay_frames;
+
+    std::deque<Frame> _pending;
+    std::vector<Frame> _free_frames;
+
+    // Folded by the worker thread without the lock
+    Histogram _work;
+
+    // Published by the worker thread after each frame
+    Histogram _shown;
+    uint64_t _generation;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // DSVIEW_PV_DATA_DSOPERSISTENCE_H
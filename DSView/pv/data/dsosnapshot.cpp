@@ -40,13 +40,10 @@ const float DsoSnapshot::LogEnvelopeScaleFactor =
 	logf(EnvelopeScaleFactor);
 const uint64_t DsoSnapshot::EnvelopeDataUnit = 4*1024;	// bytes
 
-const int DsoSnapshot::VrmsScaleFactor = 1 << 8;
-
 DsoSnapshot::DsoSnapshot() :
     Snapshot(sizeof(uint16_t), 1, 1)
 {   
     _envelope_en = false;
-    _envelope_done = false;
     _instant = false;
     _threshold = 0;
     _measure_voltage_factor1 = 0;
@@ -56,25 +53,131 @@ DsoSnapshot::DsoSnapshot() :
     _is_file = false;
     _ref_min = 0;
     _ref_max = 0;
-    _data_out_off_range = false;
+    _frame_counter = 0;
+    _writer_thread = std::thread::id();
+
+    _published = 0;
+    _dropped = 0;
+    _acquired = 0;
 
-	memset(_envelope_levels, 0, sizeof(_envelope_levels));
+    _write_set = new_frame_set(false);
+    _view_set = _write_set;
+    _pending_set = NULL;
 }
 
 DsoSnapshot::~DsoSnapshot()
 {
-    free_envelop();
+    if (_view_set != _write_set)
+        free_frame_set(_view_set);
+    free_frame_set(_write_set);
+}
+
+DsoSnapshot::FrameSet* DsoSnapshot::new_frame_set(bool instant)
+{
+    FrameSet *fs = new FrameSet();
+
+    for (auto &f : fs->frames) {
+        f.envelope_done = false;
+        f.sample_count = 0;
+        f.frame_index = _frame_counter;
+        f.data_out_off_range = false;
+        memset(f.envelope_levels, 0, sizeof(f.envelope_levels));
+    }
+
+    fs->channel_num = 0;
+    fs->total_sample_count = 0;
+    fs->instant = instant;
+
+    // An instant frame grows in one slot, the others go round the three slots
+    if (instant) {
+        fs->write_slot = 0;
+        fs->ready_slot = 0;
+    }
+    else {
+        fs->write_slot = 1;
+        fs->ready_slot = 2;
+    }
+    fs->latest_slot = 0;
+    fs->read_slot = 0;
+
+    return fs;
+}
+
+bool DsoSnapshot::alloc_frame_set(FrameSet *fs, GSList *channels,
+                                  uint64_t total_sample_count, bool isFile)
+{
+    for (const GSList *l = channels; l; l = l->next) {
+        sr_channel *const probe = (sr_channel*)l->data;
+
+        if (probe->type == SR_CHANNEL_DSO && (probe->enabled || isFile)) {
+            fs->ch_index.push_back(probe->index);
+        }
+    }
+    fs->channel_num = fs->ch_index.size();
+    fs->total_sample_count = total_sample_count;
+
+    // The instant mode only uses the first slot
+    const int slots = fs->instant ? 1 : FrameSlots;
+
+    for (int slot = 0; slot < slots; slot++) {
+        for (unsigned int i = 0; i < fs->channel_num; i++) {
+            uint8_t *chan_buffer = (uint8_t*)malloc(total_sample_count + 1);
+            if (chan_buffer == NULL){
+                dsv_err("DsoSnapshot::first_payload, Malloc memory failed!");
+                return false;
+            }
+            fs->frames[slot].ch_data.push_back(chan_buffer);
+        }
+    }
+
+    for (int slot = 0; slot < slots; slot++) {
+        for (unsigned int i = 0; i < fs->channel_num; i++) {
+            uint64_t envelop_count = total_sample_count / EnvelopeScaleFactor;
+            Envelope *const levels = fs->frames[slot].envelope_levels[i];
+
+            for (unsigned int level = 0; level < ScaleStepCount; level++) {
+                
+                envelop_count = ((envelop_count + EnvelopeDataUnit - 1) / EnvelopeDataUnit) 
+                                    * EnvelopeDataUnit;
+
+                uint64_t buffer_len = envelop_count * sizeof(EnvelopeSample);
+                levels[level].samples = (EnvelopeSample*)malloc(buffer_len);
+                
+                if (levels[level].samples == NULL) {
+                    dsv_err("DsoSnapshot::first_payload, malloc failed!");
+                    return false;
+                }
+                
+                envelop_count = envelop_count / EnvelopeScaleFactor;
+            }
+        }
+    }
+
+    return true;
+}
+
+void DsoSnapshot::free_frame_set(FrameSet *fs)
+{
+    for (auto &f : fs->frames) {
+        for (void *p : f.ch_data)
+            free(p);
+    }
+    free_envelop(fs);
+    delete fs;
 }
 
-void DsoSnapshot::free_envelop()
+void DsoSnapshot::free_envelop(FrameSet *fs)
 {
-    for (unsigned int i = 0; i < _channel_num; i++) {
-        for(auto &e : _envelope_levels[i]) {
-            if (e.samples)
-                free(e.samples);
+    for (auto &f : fs->frames) {
+        for (unsigned int i = 0; i < fs->channel_num; i++) {
+            for(auto &e : f.envelope_levels[i]) {
+                if (e.samples)
+                    free(e.samples);
+            }
         }
+        memset(f.envelope_levels, 0, sizeof(f.envelope_levels));
+        f.envelope_done = false;
     }
-    memset(_envelope_levels, 0, sizeof(_envelope_levels));
 }
 
 void DsoSnapshot::init()
@@ -89,22 +192,42 @@ void DsoSnapshot::init_all()
     _ring_sample_count = 0;
     _memory_failed = false;
     _last_ended = true;
-    _envelope_done = false;   
     _is_file = false; 
+    _frame_counter++;
+
+    reset_frame_set(_view_set);
+    if (_write_set != _view_set)
+        reset_frame_set(_write_set);
+}
+
+void DsoSnapshot::reset_frame_set(FrameSet *fs)
+{
+    for (auto &f : fs->frames) {
+        f.envelope_done = false;
+        f.sample_count = 0;
+        f.frame_index = _frame_counter;
+        f.data_out_off_range = false;
+
+        for (auto &s : f.ch_stats) {
+            s.clear();
+        }
 
-    for (unsigned int i = 0; i < _channel_num; i++) {
-        for (unsigned int level = 0; level < ScaleStepCount; level++) {
-            _envelope_levels[i][level].length = 0;
-            _envelope_levels[i][level].data_length = 0;
+        for (unsigned int i = 0; i < fs->channel_num; i++) {
+            for (unsigned int level = 0; level < ScaleStepCount; level++) {
+                f.envelope_levels[i][level].length = 0;
+                f.envelope_levels[i][level].data_length = 0;
+            }
         }
     }
+
+    // A frame published before is not taken any more
+    fs->ready_slot = fs->ready_slot & SlotMask;
 }
 
 void DsoSnapshot::clear()
 {
     std::lock_guard<std::mutex> lock(_mutex);
     free_data();
-    free_envelop();
     init_all();
     _envelope_en = false;
 }
@@ -113,13 +236,14 @@ void DsoSnapshot::free_data()
 {
     Snapshot::free_data();
 
-    for (int i=0; i<(int)_ch_data.size(); i++)
-    {
-        void *p = _ch_data[i];
-        free(p);
-    }
+    // Nothing is collected now, all the sets go
+    _pending_set = NULL;
+    if (_view_set != _write_set)
+        free_frame_set(_view_set);
+    free_frame_set(_write_set);
 
-    _ch_data.clear();
+    _write_set = new_frame_set(false);
+    _view_set = _write_set;
 }
 
 void DsoSnapshot::first_payload(const sr_datafeed_dso &dso, uint64_t total_sample_count,
@@ -127,6 +251,8 @@ void DsoSnapshot::first_payload(const sr_datafeed_dso &dso, uint64_t total_sampl
 {
     assert(channels);  
 
+    _writer_thread = std::this_thread::get_id();
+
     bool channel_changed = false;
     uint16_t channel_num = 0;
     _is_file = isFile;
@@ -149,60 +275,28 @@ void DsoSnapshot::first_payload(const sr_datafeed_dso &dso, uint64_t total_sampl
     _instant = instant;
     bool isOk = true;
 
-    if (total_sample_count != _total_sample_count
-        || channel_num != _channel_num
+    if (total_sample_count != _write_set->total_sample_count
+        || channel_num != _write_set->channel_num
         || channel_changed
+        || instant != _write_set->instant
         || isFile){
-        
-        std::lock_guard<std::mutex> lock(_mutex);
 
-        free_data();
+        // The view may be painting the old buffers, a new set is built aside
+        FrameSet *fs = new_frame_set(instant);
 
-        _ch_index.clear();
-        _total_sample_count = total_sample_count;
-        _channel_num = channel_num; 
+        if (alloc_frame_set(fs, channels, total_sample_count, isFile)) {
+            // A set the view never took is freed here, the one it holds goes in acquire_frame()
+            FrameSet *untaken = _pending_set.exchange(fs);
+            if (untaken != NULL)
+                free_frame_set(untaken);
 
-         for (const GSList *l = channels; l; l = l->next) {
-            sr_channel *const probe = (sr_channel*)l->data;
-
-            if (probe->type == SR_CHANNEL_DSO && (probe->enabled || isFile)) {
-                
-                uint8_t *chan_buffer = (uint8_t*)malloc(total_sample_count + 1);
-                if (chan_buffer == NULL){
-                    isOk = false;
-                    dsv_err("DsoSnapshot::first_payload, Malloc memory failed!");
-                    break;
-                }
-                _ch_data.push_back(chan_buffer);
-                _ch_index.push_back(probe->index);
-            }
+            _write_set = fs;
+            _total_sample_count = total_sample_count;
+            _channel_num = channel_num;
         }
-        
-        if (isOk) {
-            free_envelop();
-
-            for (unsigned int i = 0; i < _channel_num; i++) {
-                uint64_t envelop_count = _total_sample_count / EnvelopeScaleFactor;
-
-                for (unsigned int level = 0; level < ScaleStepCount; level++) {
-                    
-                    envelop_count = ((envelop_count + EnvelopeDataUnit - 1) / EnvelopeDataUnit) 
-                                        * EnvelopeDataUnit;
-
-                    uint64_t buffer_len = envelop_count * sizeof(EnvelopeSample);
-                    _envelope_levels[i][level].samples = (EnvelopeSample*)malloc(buffer_len);
-                    
-                    if (_envelope_levels[i][level].samples == NULL) {
-                        dsv_err("DsoSnapshot::first_payload, malloc failed!");
-                        isOk = false;
-                        break;
-                    }
-                    
-                    envelop_count = envelop_count / EnvelopeScaleFactor;
-                }
-                if (!isOk)
-                    break;
-            }
+        else {
+            free_frame_set(fs);
+            isOk = false;
         }
     }
 
@@ -212,81 +306,185 @@ void DsoSnapshot::first_payload(const sr_datafeed_dso &dso, uint64_t total_sampl
         _last_ended = false;
     }
     else {
-        std::lock_guard<std::mutex> lock(_mutex);
-        free_data();
-        free_envelop();
         _memory_failed = true;
     }
 }
 
 void DsoSnapshot::append_payload(const sr_datafeed_dso &dso)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    _writer_thread = std::this_thread::get_id();
+
+    if (_instant) {
+        // The view reads the same slot, the samples are appended under the lock
+        std::lock_guard<std::mutex> lock(_mutex);
+        Frame &f = _write_set->frames[_write_set->write_slot];
+
+        if (_channel_num > 0 && dso.num_samples > 0) {
+            append_data(f, dso.data, dso.num_samples, true);
+
+            // Generate the first mip-map from the data
+            if (_envelope_en)
+                append_payload_to_envelope_levels(f, dso.samplerate_tog);
+        }
+        _sample_count = f.sample_count;
+        return;
+    }
+
+    // Nobody else reads the slot being written, no lock is taken
+    if (_channel_num > 0 && dso.num_samples > 0) {
+        Frame &f = _write_set->frames[_write_set->write_slot];
 
-    if (_channel_num > 0 && dso.num_samples > 0) {       
-        append_data(dso.data, dso.num_samples, _instant);
+        append_data(f, dso.data, dso.num_samples, false);
 
-        // Generate the first mip-map from the data
+        // The slot held an older frame, its mip-map is built again or dropped
         if (_envelope_en)
-            append_payload_to_envelope_levels(dso.samplerate_tog);
+            append_payload_to_envelope_levels(f, true);
+        else
+            f.envelope_done = false;
+
+        publish_frame();
     }
 }
 
-void DsoSnapshot::append_data(void *data, uint64_t samples, bool instant)
+void DsoSnapshot::publish_frame()
+{
+    FrameSet *fs = _write_set;
+    Frame &f = fs->frames[fs->write_slot];
+
+    f.frame_index = ++_frame_counter;
+    _sample_count = f.sample_count;
+    fs->latest_slot = fs->write_slot;
+
+    // The slot of the last frame goes out, the one not taken by the view comes back
+    const int prev = fs->ready_slot.exchange(fs->write_slot | FreshFrame);
+    if (prev & FreshFrame)
+        _dropped++;
+    fs->write_slot = prev & SlotMask;
+    _published++;
+}
+
+bool DsoSnapshot::acquire_frame()
 {
-    uint64_t old_sample_count = _sample_count;
+    take_pending_set();
 
-    _data_out_off_range = false;
+    FrameSet *fs = _view_set;
+
+    if (fs->instant || (fs->ready_slot.load() & FreshFrame) == 0)
+        return false;
+
+    const int prev = fs->ready_slot.exchange(fs->read_slot);
+    fs->read_slot = prev & SlotMask;
+    _acquired++;
+    return true;
+}
+
+void DsoSnapshot::take_pending_set()
+{
+    if (_pending_set.load() == NULL)
+        return;
+
+    // The view has left the frame it painted, its buffers can go now.
+    // The readers of an instant frame on other threads hold the lock.
+    std::lock_guard<std::mutex> lock(_mutex);
+    FrameSet *fs = _pending_set.exchange(NULL);
+
+    if (fs != NULL) {
+        free_frame_set(_view_set);
+        _view_set = fs;
+    }
+}
+
+void DsoSnapshot::get_frame_counters(FrameCounters &c)
+{
+    c.published = _published;
+    c.dropped = _dropped;
+    c.acquired = _acquired;
+}
+
+std::unique_lock<std::mutex> DsoSnapshot::instant_lock()
+{
+    // Only an instant frame is appended while the view reads it
+    if (_instant)
+        return std::unique_lock<std::mutex>(_mutex);
+    return std::unique_lock<std::mutex>(_mutex, std::defer_lock);
+}
+
+uint64_t DsoSnapshot::get_sample_count()
+{
+    auto lock = instant_lock();
+    return reader_frame().sample_count;
+}
+
+void DsoSnapshot::append_data(Frame &f, void *data, uint64_t samples, bool instant)
+{
+    uint64_t old_sample_count = instant ? f.sample_count : 0;
+
+    f.data_out_off_range = false;
+
+    // An instant frame grows with the packets, the others are replaced
+    if (instant && old_sample_count == 0)
+        f.frame_index = ++_frame_counter;
 
     if (instant) { 
-        if(_sample_count + samples > _total_sample_count)
-            samples = _total_sample_count - _sample_count;
-        _sample_count += samples;
+        if(f.sample_count + samples > _total_sample_count)
+            samples = _total_sample_count - f.sample_count;
+        f.sample_count += samples;
     }
     else {
-        _sample_count = samples;
+        f.sample_count = samples;
     }
 
-    assert(_sample_count <= _total_sample_count);
-     
+    assert(f.sample_count <= _total_sample_count);
+    assert(_channel_num <= 2*DS_MAX_DSO_PROBES_NUM);
+
+    uint8_t *dest[2*DS_MAX_DSO_PROBES_NUM];
+    SampleStats stats[2*DS_MAX_DSO_PROBES_NUM];
+
     for (unsigned int ch = 0; ch < _channel_num; ch++)
     {
-        uint8_t *src = (uint8_t*)data + ch;
-        uint8_t *dest = _ch_data[ch];
+        dest[ch] = f.ch_data[ch];
 
         if (instant){
-            dest += old_sample_count;
+            dest[ch] += old_sample_count;
         }
+    }
 
-        for (uint64_t i = 0; i < samples; i++)
-        {
-            *dest++ = *src;
+    // Split the channels, check the range and gather the measure statistics in one pass
+    deinterleave((uint8_t*)data, samples, _channel_num, dest, stats);
 
-            if (*src > _ref_max || *src < _ref_min){
-                _data_out_off_range = true;
-            }
-            
-            src += _channel_num;
-        }  
+    for (unsigned int ch = 0; ch < _channel_num && samples > 0; ch++)
+    {
+        if (stats[ch].max > _ref_max || stats[ch].min < _ref_min){
+            f.data_out_off_range = true;
+        }
+
+        if (instant && old_sample_count > 0)
+            f.ch_stats[ch].add(stats[ch]);
+        else
+            f.ch_stats[ch] = stats[ch];
     }
 }
 
 void DsoSnapshot::enable_envelope(bool enable)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (!_envelope_done && enable)
-        append_payload_to_envelope_levels(true);
+    auto lock = instant_lock();
+    Frame &f = reader_frame();
+
+    // The frame of the view belongs to its thread, the mip-map is added in place
+    if (!f.envelope_done && enable)
+        append_payload_to_envelope_levels(f, true);
     _envelope_en = enable;
 }
 
 const uint8_t *DsoSnapshot::get_samples(int64_t start_sample, int64_t end_sample, uint16_t ch_index)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    auto lock = instant_lock();
+    Frame &f = reader_frame();
 
 	assert(start_sample >= 0);
-    assert(start_sample < (int64_t)_sample_count);
+    assert(start_sample < (int64_t)f.sample_count);
 	assert(end_sample >= 0);
-    assert(end_sample < (int64_t)_sample_count);
+    assert(end_sample < (int64_t)f.sample_count);
 	assert(start_sample <= end_sample);
 
     int order = get_ch_order(ch_index);
@@ -296,17 +494,20 @@ const uint8_t *DsoSnapshot::get_samples(int64_t start_sample, int64_t end_sample
         assert(false);
     } 
 
-    return (uint8_t*)_ch_data[order] + start_sample;
+    return (uint8_t*)f.ch_data[order] + start_sample;
 }
 
 void DsoSnapshot::get_envelope_section(EnvelopeSection &s,
     uint64_t start, uint64_t end, float min_length, int probe_index)
 {
-	assert(end <= get_sample_count());
+    auto lock = instant_lock();
+    Frame &f = reader_frame();
+
+	assert(end <= f.sample_count);
 	assert(start <= end);
 	assert(min_length > 0);
 
-    if (!_envelope_done) {
+    if (!f.envelope_done) {
         s.length = 0;
         return;
     }
@@ -320,12 +521,12 @@ void DsoSnapshot::get_envelope_section(EnvelopeSection &s,
 
 	s.start = start << scale_power;
 	s.scale = 1 << scale_power;
-    if (_envelope_levels[probe_index][min_level].length == 0)
+    if (f.envelope_levels[probe_index][min_level].length == 0)
         s.length = 0;
     else
         s.length = end - start;
 
-    s.samples = _envelope_levels[probe_index][min_level].samples + start;
+    s.samples = f.envelope_levels[probe_index][min_level].samples + start;
 }
 
 void DsoSnapshot::reallocate_envelope(Envelope &e)
@@ -338,10 +539,10 @@ void DsoSnapshot::reallocate_envelope(Envelope &e)
 	}
 }
 
-void DsoSnapshot::append_payload_to_envelope_levels(bool header)
+void DsoSnapshot::append_payload_to_envelope_levels(Frame &f, bool header)
 {
-    for (unsigned int i = 0; i < _channel_num; i++) {
-        Envelope &e0 = _envelope_levels[i][0];
+    for (unsigned int i = 0; i < f.ch_data.size(); i++) {
+        Envelope &e0 = f.envelope_levels[i][0];
         uint64_t prev_length;
         EnvelopeSample *dest_ptr;
 
@@ -349,7 +550,7 @@ void DsoSnapshot::append_payload_to_envelope_levels(bool header)
             prev_length = 0;
         else
             prev_length = e0.length;
-        e0.length = _sample_count / EnvelopeScaleFactor;
+        e0.length = f.sample_count / EnvelopeScaleFactor;
 
         if (e0.length == 0)
             return;
@@ -361,36 +562,18 @@ void DsoSnapshot::append_payload_to_envelope_levels(bool header)
 
         assert(e0.samples);
 
-        dest_ptr = e0.samples + prev_length;
-
-        // Iterate through the samples to populate the first level mipmap
-        const uint8_t *const stop_src_ptr = (uint8_t*)_ch_data[i] + e0.length * EnvelopeScaleFactor;
-        const uint8_t *src_ptr = (uint8_t*)_ch_data[i] + prev_length * EnvelopeScaleFactor;
-
-        for (; src_ptr < stop_src_ptr; src_ptr += EnvelopeScaleFactor)
-        {
-            const uint8_t *begin_src_ptr = src_ptr;
-            const uint8_t *const end_src_ptr = src_ptr + EnvelopeScaleFactor;
-
-            EnvelopeSample sub_sample;
-            sub_sample.min = *begin_src_ptr;
-            sub_sample.max = *begin_src_ptr;
-
-            while (begin_src_ptr < end_src_ptr)
-            {
-                sub_sample.min = ds_min(sub_sample.min, *begin_src_ptr);
-                sub_sample.max = ds_max(sub_sample.max, *begin_src_ptr);
-                begin_src_ptr++;
-            }
-            
-            *dest_ptr++ = sub_sample;
+        // Populate the first level mipmap
+        if (e0.length > prev_length) {
+            envelope_contiguous((uint8_t*)f.ch_data[i] + prev_length * EnvelopeScaleFactor,
+                                e0.length - prev_length, EnvelopeScaleFactor,
+                                (uint8_t*)(e0.samples + prev_length));
         }
 
         // Compute higher level mipmaps
         for (unsigned int level = 1; level < ScaleStepCount; level++)
         {
-            Envelope &e = _envelope_levels[i][level];
-            const Envelope &el = _envelope_levels[i][level-1];
+            Envelope &e = f.envelope_levels[i][level];
+            const Envelope &el = f.envelope_levels[i][level-1];
 
             // Expand the data buffer to fit the new samples
             if (header)
@@ -430,73 +613,47 @@ void DsoSnapshot::append_payload_to_envelope_levels(bool header)
             }
         }
     }
-    _envelope_done = true;
+    f.envelope_done = true;
 }
 
 double DsoSnapshot::cal_vrms(double zero_off, int index)
 {
-    assert(index >= 0);
+    auto lock = instant_lock();
+    const Frame &f = reader_frame();
 
-    // root-meam-squart value
-    double vrms_pre = 0;
-    double vrms = 0;
-    double tmp;
+    assert(index >= 0);
+    assert(index < (int)f.ch_data.size());
 
-    // Iterate through the samples to populate the first level mipmap
-    const uint8_t *const stop_src_ptr = (uint8_t*)_ch_data[index] + _sample_count;
-    const uint8_t *src_ptr = (uint8_t*)_ch_data[index];
+    if (f.sample_count == 0)
+        return 0;
 
-    for (;src_ptr < stop_src_ptr; src_ptr += VrmsScaleFactor)
-    {
-        const uint8_t * begin_src_ptr = src_ptr;
-        const uint8_t *const end_src_ptr = src_ptr + VrmsScaleFactor;
+    // root-meam-squart value, sum((zero_off - x)^2) expanded on the frame sums
+    const SampleStats &s = f.ch_stats[index];
+    double vrms = zero_off * zero_off
+                  - 2 * zero_off * s.sum / f.sample_count
+                  + (double)s.square_sum / f.sample_count;
 
-        while (begin_src_ptr < end_src_ptr)
-        {
-            tmp = (zero_off - *begin_src_ptr);
-            vrms += tmp * tmp;
-            begin_src_ptr++;
-        }
-        vrms = vrms_pre + vrms / _sample_count;
-        vrms_pre = vrms;
-    }
-    vrms = pow(vrms, 0.5);
-
-    return vrms;
+    return sqrt(max(vrms, 0.0));
 }
 
 double DsoSnapshot::cal_vmean(int index)
 {
-    assert(index >= 0);
+    auto lock = instant_lock();
+    const Frame &f = reader_frame();
 
-    // mean value
-    double vmean_pre = 0;
-    double vmean = 0;
+    assert(index >= 0);
+    assert(index < (int)f.ch_data.size());
 
-    // Iterate through the samples to populate the first level mipmap
-    const uint8_t *const stop_src_ptr = (uint8_t*)_ch_data[index] + _sample_count;
-    const uint8_t *src_ptr = (uint8_t*)_ch_data[index];
+    if (f.sample_count == 0)
+        return 0;
 
-    for (; src_ptr < stop_src_ptr; src_ptr += VrmsScaleFactor)
-    {
-        const uint8_t * begin_src_ptr = src_ptr;
-        const uint8_t *const end_src_ptr = src_ptr + VrmsScaleFactor;
-
-        while (begin_src_ptr < end_src_ptr)
-        {
-            vmean += *begin_src_ptr;
-            begin_src_ptr += _channel_num;
-        }
-        vmean = vmean_pre + vmean / _sample_count;
-        vmean_pre = vmean;
-    }
-
-    return vmean;
+    // mean value
+    return (double)f.ch_stats[index].sum / f.sample_count;
 }
 
 int DsoSnapshot::get_block_num()
 {
-    const uint64_t size = _sample_count * get_unit_bytes() * get_channel_num();
+    const uint64_t size = reader_frame().sample_count * get_unit_bytes() * reader_set().channel_num;
     return (size >> LeafBlockPower) +
            ((size & LeafMask) != 0);
 }
@@ -508,7 +665,7 @@ uint64_t DsoSnapshot::get_block_size(int block_index)
     if (block_index < get_block_num() - 1) {
         return LeafBlockSamples;
     } else {
-        const uint64_t size = _sample_count * get_unit_bytes() * get_channel_num();
+        const uint64_t size = reader_frame().sample_count * get_unit_bytes() * reader_set().channel_num;
         if (size % LeafBlockSamples == 0)
             return LeafBlockSamples;
         else
@@ -518,31 +675,51 @@ uint64_t DsoSnapshot::get_block_size(int block_index)
 
 bool DsoSnapshot::get_max_min_value(uint8_t &maxv, uint8_t &minv, int chan_index)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    auto lock = instant_lock();
+    const Frame &f = reader_frame();
 
-    if (_sample_count == 0){
+    if (f.sample_count == 0){
         return false;
     }
 
-    if (chan_index < 0 || chan_index >= (int)_ch_data.size()){
+    if (chan_index < 0 || chan_index >= (int)f.ch_data.size()){
         assert(false);
     }
 
-    uint8_t *p = _ch_data[chan_index];
-    maxv = *p;
-    minv = *p;
+    maxv = f.ch_stats[chan_index].max;
+    minv = f.ch_stats[chan_index].min;
+    
+    return true;
+}
+
+bool DsoSnapshot::get_sample_stats(int sig_index, SampleStats &stats, uint64_t &sample_count)
+{
+    auto lock = instant_lock();
+    const Frame &f = reader_frame();
+
+    int order = get_ch_order(sig_index);
 
-    for (uint64_t i=1; i<_sample_count; i++){
-        p++;
-        if (*p > maxv)
-            maxv = *p;
-        if (*p < minv)
-            minv = *p;
+    if (order == -1 || f.sample_count == 0){
+        return false;
     }
-    
+
+    stats = f.ch_stats[order];
+    sample_count = f.sample_count;
     return true;
 }
 
+uint64_t DsoSnapshot::get_frame_index()
+{
+    auto lock = instant_lock();
+    return reader_frame().frame_index;
+}
+
+bool DsoSnapshot::data_is_out_off_range()
+{
+    auto lock = instant_lock();
+    return reader_frame().data_out_off_range;
+}
+
 bool DsoSnapshot::has_data(int sig_index)
 {
     return get_ch_order(sig_index) != -1;
@@ -552,7 +729,7 @@ int DsoSnapshot::get_ch_order(int sig_index)
 {
     uint16_t order = 0;
 
-    for (uint16_t i : _ch_index) {
+    for (uint16_t i : reader_set().ch_index) {
         if (i == sig_index)
             return order;
         else
@@ -25,9 +25,12 @@
 
 #include <utility>
 #include <vector>
+#include <atomic>
+#include <thread>
 
 #include <libsigrok.h> 
 #include "snapshot.h"
+#include "samplekernel.h"
  
 namespace DsoSnapshotTest {
 class Basic;
@@ -53,6 +56,13 @@ public:
 		EnvelopeSample *samples;
 	};
 
+    struct FrameCounters
+    {
+        uint64_t published;  // frames handed over by the acquisition
+        uint64_t dropped;    // replaced before the view took them
+        uint64_t acquired;   // frames taken by the view
+    };
+
 private:
 	struct Envelope
 	{
@@ -68,11 +78,47 @@ private:
 	static const float LogEnvelopeScaleFactor;
 	static const uint64_t EnvelopeDataUnit;
 
+    static const int FrameSlots = 3;
+    static const int SlotMask = 3;
+    static const int FreshFrame = 4;     // the published slot was not taken yet
+
     static const uint64_t LeafBlockPower = 21;
     static const uint64_t LeafBlockSamples = 1 << LeafBlockPower;
     static const uint64_t LeafMask = ~(~0ULL << LeafBlockPower);
 
-    static const int VrmsScaleFactor;
+    /*
+     * The samples of one frame with all that is derived from them.
+     * The acquisition writes a frame nobody else reads, publishes it,
+     * and the view takes the last published one when it paints.
+     */
+    struct Frame
+    {
+        std::vector<uint8_t*> ch_data;
+        Envelope envelope_levels[2*DS_MAX_DSO_PROBES_NUM][ScaleStepCount];
+        bool envelope_done;
+        uint64_t sample_count;
+        uint64_t frame_index;
+        bool data_out_off_range;
+        SampleStats ch_stats[2*DS_MAX_DSO_PROBES_NUM];
+    };
+
+    /*
+     * The frames of one buffer layout. A new layout is built aside and
+     * the view takes it in acquire_frame(), so the buffers it paints are
+     * freed only after it has left them.
+     */
+    struct FrameSet
+    {
+        Frame frames[FrameSlots];
+        std::vector<uint16_t> ch_index;
+        unsigned int channel_num;
+        uint64_t total_sample_count;
+        bool instant;
+        int write_slot;                 // owned by the acquisition thread
+        int latest_slot;                // the last one it published
+        std::atomic<int> ready_slot;    // published, waits for the view
+        int read_slot;                  // owned by the view
+    };
 
 private:
     void init_all();
@@ -95,6 +141,19 @@ public:
         uint64_t start, uint64_t end, float min_length, int probe_index);
 
     void enable_envelope(bool enable);
+
+    /*
+     * Called by the view before it paints, takes the last published frame.
+     * The frame keeps still until the next call, the acquisition writes the other slots.
+     * A new buffer layout is taken here too, the buffers of the old one are freed.
+     * Returns false if no new frame was published.
+     */
+    bool acquire_frame();
+
+    void get_frame_counters(FrameCounters &c);
+
+    uint64_t get_sample_count() override;
+
     double cal_vrms(double zero_off, int index);
     double cal_vmean(int index);
     bool has_data(int sig_index);
@@ -103,6 +162,9 @@ public:
 
     bool get_max_min_value(uint8_t &maxv, uint8_t &minv, int chan_index);
 
+    // The statistics of a channel over the frame, gathered while the samples are appended
+    bool get_sample_stats(int sig_index, SampleStats &stats, uint64_t &sample_count);
+
     inline void set_threshold(float threshold){
         _threshold = threshold;
     }
@@ -136,24 +198,57 @@ public:
         _ref_min = ref_min;
     }
 
-    inline bool data_is_out_off_range(){
-        return _data_out_off_range;
-    }
+    bool data_is_out_off_range();
+
+    // Changes when a new frame takes the place of the samples
+    uint64_t get_frame_index();
 
 private:
-    void append_data(void *data, uint64_t samples, bool instant);
-    void free_envelop();
+    void append_data(Frame &f, void *data, uint64_t samples, bool instant);
+    void free_envelop(FrameSet *fs);
 	void reallocate_envelope(Envelope &l);
-    void append_payload_to_envelope_levels(bool header);
+    void append_payload_to_envelope_levels(Frame &f, bool header);
     void free_data();   
     int  get_ch_order(int sig_index);
+    void publish_frame();
+    std::unique_lock<std::mutex> instant_lock();
+
+    FrameSet* new_frame_set(bool instant);
+    bool alloc_frame_set(FrameSet *fs, GSList *channels, uint64_t total_sample_count, bool isFile);
+    void free_frame_set(FrameSet *fs);
+    void reset_frame_set(FrameSet *fs);
+    void take_pending_set();
+
+    /*
+     * The frames of the caller: the acquisition thread reads the set it writes,
+     * the others the set taken by acquire_frame().
+     */
+    inline FrameSet& reader_set(){
+        return *(std::this_thread::get_id() == _writer_thread ? _write_set : _view_set);
+    }
+
+    /*
+     * The frame of the caller: the acquisition thread reads the frame it published last,
+     * the others the frame taken by acquire_frame().
+     */
+    inline Frame& reader_frame(){
+        if (std::this_thread::get_id() == _writer_thread)
+            return _write_set->frames[_write_set->latest_slot];
+        return _view_set->frames[_view_set->read_slot];
+    }
 
 private:
-    struct Envelope _envelope_levels[2*DS_MAX_DSO_PROBES_NUM][ScaleStepCount];
-    bool    _envelope_en;
-    bool    _envelope_done;
-    bool    _instant; 
-    std::vector<uint8_t*>   _ch_data;
+    FrameSet *_write_set;               // owned by the acquisition thread
+    FrameSet *_view_set;                // owned by the view
+    std::atomic<FrameSet*> _pending_set; // a new layout, not taken by the view yet
+    std::atomic<std::thread::id> _writer_thread;
+    uint64_t _frame_counter;
+    std::atomic<uint64_t> _published;
+    std::atomic<uint64_t> _dropped;
+    std::atomic<uint64_t> _acquired;
+
+    std::atomic<bool> _envelope_en;
+    std::atomic<bool> _instant;
     float   _threshold;
     uint64_t _measure_voltage_factor1;
     uint64_t _measure_voltage_factor2;
@@ -162,7 +257,6 @@ private:
     bool    _is_file;
     uint32_t _ref_min;
     uint32_t _ref_max;
-    bool _data_out_off_range;
  
     friend class DsoSnapshotTest::Basic;
 };
@@ -24,6 +24,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <algorithm>
  
 #include "logicsnapshot.h"
 #include "../dsvdef.h"
@@ -214,7 +215,99 @@ void LogicSnapshot::append_payload(const sr_datafeed_logic &logic)
 {
     std::lock_guard<std::mutex> lock(_mutex);
 
-    append_cross_payload(logic);
+    if (logic.format == LA_SPLIT_DATA)
+        append_split_payload(logic);
+    else
+        append_cross_payload(logic);
+}
+
+/*
+ * One block of one channel, the channels of a block come in their order.
+ * The block is copied into the leaf blocks, a leaf block without toggles is
+ * not allocated when the packet has no data.
+ */
+void LogicSnapshot::append_split_payload(const sr_datafeed_logic &logic)
+{
+    assert(logic.format == LA_SPLIT_DATA);
+    assert(logic.length % ScaleSize == 0);
+
+    const unsigned int order = logic.index;
+    if (order >= _channel_num){
+        dsv_err("LogicSnapshot::append_split_payload, invalid channel order:%d", order);
+        return;
+    }
+
+    const uint8_t *src = (const uint8_t*)logic.data;
+    const uint8_t level = logic.level ? 0xff : 0;
+    uint64_t index = _ring_sample_count;
+    uint64_t samples = logic.length * 8;
+    const uint64_t space = _ch_data[order].size() * RootNodeSamples;
+
+    if (index + samples > space){
+        dsv_err("LogicSnapshot::append_split_payload, too many samples!");
+        samples = space - index;
+    }
+
+    // The saved mipmap of the leaf block follows the samples
+    const uint8_t *mipmap = NULL;
+    if (src != NULL && logic.mipmap_length == LeafMipmapSpace
+        && index % LeafBlockSamples == 0 && samples <= LeafBlockSamples){
+        mipmap = src + logic.length;
+    }
+
+    while (samples > 0)
+    {
+        uint64_t index0 = index / LeafBlockSamples / RootScale;
+        uint64_t index1 = (index / LeafBlockSamples) % RootScale;
+        uint64_t offset = index % LeafBlockSamples;
+        uint64_t count = std::min(samples, LeafBlockSamples - offset);
+        void *lbp = _ch_data[order][index0].lbp[index1];
+
+        if (src == NULL && offset == 0 && count == LeafBlockSamples && lbp == NULL)
+        {
+            if (level){
+                _ch_data[order][index0].first |= 1ULL << index1;
+                _ch_data[order][index0].last |= 1ULL << index1;
+            }
+        }
+        else
+        {
+            if (lbp == NULL){
+                lbp = malloc(LeafBlockSpace);
+                if (lbp == NULL){
+                    dsv_err("LogicSnapshot::append_split_payload, Malloc memory failed!");
+                    _memory_failed = true;
+                    return;
+                }
+                _ch_data[order][index0].lbp[index1] = lbp;
+                memset(lbp, 0, LeafBlockSpace);
+            }
+
+            if (src != NULL)
+                memcpy((uint8_t*)lbp + offset / 8, src, count / 8);
+            else
+                memset((uint8_t*)lbp + offset / 8, level, count / 8);
+
+            if (mipmap != NULL){
+                memcpy((uint8_t*)lbp + LeafBlockSamples / 8, mipmap, LeafMipmapSpace);
+                calc_root_bits(order, index0, index1, count, count == LeafBlockSamples);
+            }
+            else{
+                calc_mipmap(order, index0, index1, offset + count, offset + count == LeafBlockSamples);
+            }
+        }
+
+        if (src != NULL)
+            src += count / 8;
+        index += count;
+        samples -= count;
+    }
+
+    // The last channel completes the samples of the block
+    if (order == _channel_num - 1){
+        _ring_sample_count = index;
+        _sample_count = std::min(_ring_sample_count, _total_sample_count);
+    }
 }
 
 void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
@@ -572,6 +665,14 @@ void LogicSnapshot::calc_mipmap(unsigned int order, uint8_t index0, uint8_t inde
         src_ptr++;
     }  
 
+    calc_root_bits(order, index0, index1, samples, isEnd);
+} 
+
+void LogicSnapshot::calc_root_bits(unsigned int order, uint8_t index0, uint8_t index1, uint64_t samples, bool isEnd)
+{
+    void *lbp = _ch_data[order][index0].lbp[index1];
+    void *level3_ptr = (uint8_t*)lbp + LeafBlockSpace - sizeof(uint64_t);
+
     if ((*((uint64_t*)lbp) & LSB) != 0)
         _ch_data[order][index0].first |= 1ULL << index1;
 
@@ -602,7 +703,11 @@ void LogicSnapshot::calc_mipmap(unsigned int order, uint8_t index0, uint8_t inde
 const uint8_t *LogicSnapshot::get_samples(uint64_t start_sample, uint64_t &end_sample, int sig_index, void **lbp)
 {  
     std::lock_guard<std::mutex> lock(_mutex);
+    return get_samples_unlock(start_sample, end_sample, sig_index, lbp);
+}
 
+const uint8_t *LogicSnapshot::get_samples_unlock(uint64_t start_sample, uint64_t &end_sample, int sig_index, void **lbp)
+{
     uint64_t sample_count = _ring_sample_count;
     assert(start_sample < sample_count);
 
@@ -667,6 +772,60 @@ const uint8_t *LogicSnapshot::get_samples(uint64_t start_sample, uint64_t &end_s
     }
 }
 
+uint64_t LogicSnapshot::get_decode_span(uint64_t start_sample, uint64_t end_sample, const int *sig_indexs,
+                    int num, const uint8_t **data, uint8_t *consts, void **lbps)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint64_t span_end = end_sample + 1;
+    bool bFlat = true;
+
+    for (int j = 0; j < num; j++)
+    {
+        data[j] = NULL;
+        consts[j] = 0;
+        if (lbps != NULL)
+            lbps[j] = NULL;
+
+        if (sig_indexs[j] == -1)
+            continue;
+
+        uint64_t block_end = 0;
+        data[j] = get_samples_unlock(start_sample, block_end, sig_indexs[j], lbps ? &lbps[j] : NULL);
+        consts[j] = get_sample_unlock(start_sample, sig_indexs[j]);
+        span_end = min(span_end, block_end);
+        bFlat = bFlat && (data[j] == NULL);
+    }
+
+    if (!bFlat || (_is_loop && _loop_offset > 0))
+        return span_end;
+
+    // The next blocks join the span while all channels keep their levels
+    while (span_end <= end_sample && span_end < _ring_sample_count)
+    {
+        uint64_t next_end = end_sample + 1;
+        int j = 0;
+
+        for (; j < num; j++)
+        {
+            if (sig_indexs[j] == -1)
+                continue;
+
+            uint64_t block_end = 0;
+            if (get_samples_unlock(span_end, block_end, sig_indexs[j], NULL) != NULL
+                || get_sample_unlock(span_end, sig_indexs[j]) != (consts[j] != 0))
+                break;
+            next_end = min(next_end, block_end);
+        }
+
+        if (j < num)
+            break;
+        span_end = next_end;
+    }
+
+    return span_end;
+}
+
 bool LogicSnapshot::get_sample(uint64_t index, int sig_index)
 {
     std::lock_guard<std::mutex> lock(_mutex);
@@ -1278,21 +1437,17 @@ bool LogicSnapshot::pattern_search_self(int64_t start, int64_t end, int64_t &ind
     }
   
     char flagList[CHANNEL_MAX_COUNT];
-    char lstValues[CHANNEL_MAX_COUNT];
-    int  chanIndexs[CHANNEL_MAX_COUNT];
+    int  chanOrders[CHANNEL_MAX_COUNT];
     int  count = 0;  
     bool bEdgeFlag = false;
 
-    const int64_t to = isNext ? end + 1 : start - 1;
-    const int64_t step = isNext ? 1 : -1;
-
     for (auto it = pattern.begin(); it != pattern.end(); it++){
          char flag = *(it->second.toStdString().c_str());
          int channel = it->first;
 
          if (flag != 'X' && has_data(channel)){
              flagList[count]  = flag;
-             chanIndexs[count] = channel;
+             chanOrders[count] = get_ch_order(channel);
              count++;
 
              if (flag == 'R' || flag == 'F' || flag == 'C'){
@@ -1304,17 +1459,9 @@ bool LogicSnapshot::pattern_search_self(int64_t start, int64_t end, int64_t &ind
         return true;
     }  
 
-    //find
-    bool ret = false;
-    char val = 0;
-    int macthed = 0;  
-
-    //get first edge values
+    // The edge is taken against the sample at the search cursor
     if (bEdgeFlag){
-        for (int i=0; i < count; i++){
-            lstValues[i] =  (char)get_sample_self(index, chanIndexs[i]);
-        }
-        index += step;
+        index += isNext ? 1 : -1;
     }
 
     if (index < start){
@@ -1324,60 +1471,316 @@ bool LogicSnapshot::pattern_search_self(int64_t start, int64_t end, int64_t &ind
         index = end;
     }
 
-    while (index != to)
+    if (isNext)
     {
-        macthed = 0;
+        int64_t pos = index;
 
-        for (int i = 0; i < count; i++)
+        while (pos <= end)
         {
-            val = (char)get_sample_self(index, chanIndexs[i]);
+            // Skip the largest aligned span that can not contain a match
+            bool skipped = false;
 
-            if (flagList[i] == '0')
-            {
-                macthed += !val;
+            for (unsigned int level = ScaleLevel; level > 0; level--){
+                const uint64_t span = 1ULL << (level * ScalePower);
+
+                if ((pos & (span - 1)) == 0
+                    && pattern_span_skip(pos, level, flagList, chanOrders, count, true)){
+                    pos += span;
+                    skipped = true;
+                    break;
+                }
             }
-            else if (flagList[i] == '1')
-            {
-                macthed += val;
-            } 
-            else if (flagList[i] == 'R')
-            {
-                if (isNext)
-                    macthed += (lstValues[i] == 0 && val == 1);
-                else
-                    macthed += (lstValues[i] == 1 && val == 0);
+            if (skipped)
+                continue;
+
+            const uint64_t word = pos >> ScalePower;
+            const int64_t word_start = word << ScalePower;
+            const int64_t word_end = word_start + Scale - 1;
+            uint64_t mask = pattern_match_word(word, flagList, chanOrders, count, true);
+
+            mask &= ~0ULL << (pos - word_start);
+            if (word_end > end)
+                mask &= ~0ULL >> (word_end - end);
+
+            if (mask != 0){
+                index = word_start + bsf_folded(mask);
+                return true;
             }
-            else if (flagList[i] == 'F')
-            {
-                if (isNext)
-                    macthed += (lstValues[i] == 1 && val == 0);
-                else
-                    macthed += (lstValues[i] == 0 && val == 1);
+            pos = word_end + 1;
+        }
+    }
+    else
+    {
+        int64_t pos = index;
+
+        while (pos >= start)
+        {
+            bool skipped = false;
+
+            for (unsigned int level = ScaleLevel; level > 0; level--){
+                const uint64_t span = 1ULL << (level * ScalePower);
+
+                if (((pos + 1) & (span - 1)) == 0
+                    && pattern_span_skip(pos + 1 - span, level, flagList, chanOrders, count, false)){
+                    pos -= span;
+                    skipped = true;
+                    break;
+                }
             }
-            else if (flagList[i] == 'C')
-            {   
-                if (isNext)
-                    macthed += (lstValues[i] == 0 && val == 1) || (lstValues[i] == 1 && val == 0);
-                else
-                    macthed += (lstValues[i] == 1 && val == 0) || (lstValues[i] == 0 && val == 1);
+            if (skipped)
+                continue;
+
+            const uint64_t word = pos >> ScalePower;
+            const int64_t word_start = word << ScalePower;
+            uint64_t mask = pattern_match_word(word, flagList, chanOrders, count, false);
+
+            mask &= ~0ULL >> (Scale - 1 - (pos - word_start));
+            if (word_start < start)
+                mask &= ~0ULL << (start - word_start);
+
+            if (mask != 0){
+                index = word_start + bsr64(mask) + 1; //move to prev position
+                return true;
             }
-            lstValues[i] = val;
+            pos = word_start - 1;
         }
+    }
+
+    return false;
+}
+
+/*
+ * Find the first run of at least min_length samples in [index, end] where
+ * none of the channels toggles. On success, index is the first sample of the run.
+ */
+bool LogicSnapshot::find_idle_gap(uint64_t &index, uint64_t end, uint64_t min_length,
+                    const std::vector<int> &sig_indexs)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    index += _loop_offset;
+    end += _loop_offset;
+    _ring_sample_count += _loop_offset;
+
+    bool flag = find_idle_gap_self(index, end, min_length, sig_indexs);
 
-        // matched all
-        if (macthed == count)
+    index -= _loop_offset;
+    _ring_sample_count -= _loop_offset;
+    return flag;
+}
+
+bool LogicSnapshot::find_idle_gap_self(uint64_t &index, uint64_t end, uint64_t min_length,
+                    const std::vector<int> &sig_indexs)
+{
+    int  chanOrders[CHANNEL_MAX_COUNT];
+    bool lastVals[CHANNEL_MAX_COUNT];
+    int  count = 0;
+
+    for (int sig_index : sig_indexs){
+        int order = get_ch_order(sig_index);
+
+        if (order != -1 && count < CHANNEL_MAX_COUNT){
+            chanOrders[count] = order;
+            count++;
+        }
+    }
+
+    // Runs shorter than a word are not tracked
+    if (count == 0 || min_length < Scale || _ring_sample_count == 0){
+        return false;
+    }
+
+    end = min(end, _ring_sample_count - 1);
+    if (index > end){
+        return false;
+    }
+
+    for (int i = 0; i < count; i++){
+        lastVals[i] = (get_sample_word_self(index >> ScalePower, chanOrders[i]) >> (index & LevelMask[0])) & LSB;
+    }
+
+    uint64_t gap_start = index;
+    uint64_t pos = index + 1;
+
+    while (pos <= end)
+    {
+        // Skip the largest aligned span that holds the last level on every channel
+        bool skipped = false;
+
+        for (unsigned int level = ScaleLevel; level > 0; level--){
+            const uint64_t span = 1ULL << (level * ScalePower);
+
+            if ((pos & (span - 1)) != 0)
+                continue;
+
+            bool idle = true;
+
+            for (int i = 0; idle && i < count; i++){
+                idle = is_span_constant(pos, level, chanOrders[i])
+                    && (bool)(get_sample_word_self(pos >> ScalePower, chanOrders[i]) & LSB) == lastVals[i];
+            }
+
+            if (idle){
+                pos += span;
+                skipped = true;
+                break;
+            }
+        }
+
+        if (!skipped)
         {
-            ret = true;
-            if (!isNext){
-                index++; //move to prev position
+            const uint64_t word = pos >> ScalePower;
+            const uint64_t word_start = word << ScalePower;
+            const uint64_t word_end = word_start + Scale - 1;
+            uint64_t edges = 0;
+
+            for (int i = 0; i < count; i++){
+                const uint64_t cur = get_sample_word_self(word, chanOrders[i]);
+                edges |= cur ^ ((cur << 1) | (uint64_t)lastVals[i]);
+                lastVals[i] = cur & MSB;
             }
-            break;
+
+            edges &= ~0ULL << (pos - word_start);
+            if (word_end > end)
+                edges &= ~0ULL >> (word_end - end);
+
+            if (edges != 0){
+                if (word_start + bsf_folded(edges) - gap_start >= min_length){
+                    index = gap_start;
+                    return true;
+                }
+                gap_start = word_start + bsr64(edges);
+            }
+            pos = word_end + 1;
+        }
+
+        if (min(pos, end + 1) - gap_start >= min_length){
+            index = gap_start;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint64_t LogicSnapshot::get_sample_word_self(uint64_t word, int order)
+{
+    const uint64_t index = word << ScalePower;
+
+    if (index >= _ring_sample_count)
+        return 0;
+
+    const uint64_t index0 = index >> (LeafBlockPower + RootScalePower);
+    const uint64_t index1 = (index & RootMask) >> LeafBlockPower;
+    const uint64_t root_pos_mask = 1ULL << index1;
+    const struct RootNode &rn = _ch_data[order][index0];
+
+    if ((rn.tog & root_pos_mask) == 0)
+        return (rn.first & root_pos_mask) ? ~0ULL : 0ULL;
+
+    return *((uint64_t*)rn.lbp[index1] + ((index & LeafMask) >> ScalePower));
+}
+
+bool LogicSnapshot::is_span_constant(uint64_t index, unsigned int level, int order)
+{
+    assert(level > 0 && level <= ScaleLevel);
+
+    const uint64_t index0 = index >> (LeafBlockPower + RootScalePower);
+    const uint64_t index1 = (index & RootMask) >> LeafBlockPower;
+    const struct RootNode &rn = _ch_data[order][index0];
+
+    if ((rn.tog & (1ULL << index1)) == 0)
+        return true;
+    if (level == ScaleLevel)
+        return false;
+
+    // A clear mipmap bit means no toggle after the first sample of the span
+    const uint64_t *lbp = (uint64_t*)rn.lbp[index1];
+    const uint64_t offset = (index & LeafMask) >> ((level + 1) * ScalePower);
+    const uint64_t pos = (index & LevelMask[level]) >> (level * ScalePower);
+
+    return (*(lbp + LevelOffset[level] + offset) & (1ULL << pos)) == 0;
+}
+
+bool LogicSnapshot::pattern_span_skip(uint64_t span_start, unsigned int level,
+                    const char *flags, const int *orders, int count, bool isNext)
+{
+    const uint64_t span_end = span_start + (1ULL << (level * ScalePower)) - 1;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!is_span_constant(span_start, level, orders[i]))
+            continue;
+
+        const bool val = get_sample_word_self(span_start >> ScalePower, orders[i]) & LSB;
+
+        if (flags[i] == '0' || flags[i] == '1'){
+            if (val != (flags[i] == '1'))
+                return true;
+        }
+        else if (isNext){
+            // no edge can land on the first sample of the span
+            if (span_start == 0)
+                return true;
+            const uint64_t pre = span_start - 1;
+            if ((bool)((get_sample_word_self(pre >> ScalePower, orders[i]) >> (pre & LevelMask[0])) & LSB) == val)
+                return true;
+        }
+        else{
+            // no edge between the last sample of the span and the next one
+            const uint64_t nxt = span_end + 1;
+            if ((bool)((get_sample_word_self(nxt >> ScalePower, orders[i]) >> (nxt & LevelMask[0])) & LSB) == val)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+uint64_t LogicSnapshot::pattern_match_word(uint64_t word, const char *flags,
+                    const int *orders, int count, bool isNext)
+{
+    uint64_t matched = ~0ULL;
+
+    for (int i = 0; i < count && matched != 0; i++)
+    {
+        const uint64_t cur = get_sample_word_self(word, orders[i]);
+
+        if (flags[i] == '0'){
+            matched &= ~cur;
+            continue;
         }
+        else if (flags[i] == '1'){
+            matched &= cur;
+            continue;
+        }
+
+        // Rising/falling are in time order, so searching backward compares
+        // sample i with sample i+1, and searching forward i-1 with i.
+        uint64_t rise, fall;
 
-        index += step;
+        if (isNext){
+            const uint64_t carry = (word > 0) ? get_sample_word_self(word - 1, orders[i]) >> (Scale - 1) : (cur & LSB);
+            const uint64_t pre = (cur << 1) | carry;
+            rise = ~pre & cur;
+            fall = pre & ~cur;
+        }
+        else{
+            const uint64_t carry = get_sample_word_self(word + 1, orders[i]) & LSB;
+            const uint64_t nxt = (cur >> 1) | (carry << (Scale - 1));
+            rise = ~cur & nxt;
+            fall = cur & ~nxt;
+        }
+
+        if (flags[i] == 'R')
+            matched &= rise;
+        else if (flags[i] == 'F')
+            matched &= fall;
+        else if (flags[i] == 'C')
+            matched &= rise | fall;
     }
 
-    return ret;
+    return matched;
 }
 
 bool LogicSnapshot::has_data(int sig_index)
@@ -1497,6 +1900,32 @@ uint8_t *LogicSnapshot::get_block_buf_unlock(int block_index, int sig_index, boo
     return lbp;
 }
 
+const uint8_t *LogicSnapshot::get_block_mipmap(int block_index, int sig_index, uint64_t &size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    int block_num = get_block_num_unlock();
+    assert(block_index < block_num);
+
+    int order = get_ch_order(sig_index);
+    if (order == -1 || _loop_offset % LeafBlockSamples != 0) {
+        return NULL;
+    }
+
+    block_index += _loop_offset / LeafBlockSamples;
+
+    uint64_t index = block_index / RootScale;
+    uint8_t pos = block_index % RootScale;
+    uint8_t *lbp = (uint8_t*)_ch_data[order][index].lbp[pos];
+
+    if (lbp == NULL){
+        return NULL;
+    }
+
+    size = LeafMipmapSpace;
+    return lbp + LeafBlockSamples / 8;
+}
+
 int LogicSnapshot::get_ch_order(int sig_index)
 {
     uint16_t order = 0;
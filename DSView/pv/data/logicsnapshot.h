@@ -58,6 +58,7 @@ private:
 
     static const uint64_t LeafBlockPower = ScaleLevel*ScalePower;
     static const uint64_t LeafBlockSamples = 1 << LeafBlockPower;
+    static const uint64_t LeafMipmapSpace = LeafBlockSpace - LeafBlockSamples / 8;
     static const uint64_t RootNodeSamples = LeafBlockSamples*RootScale;
 
     static const uint64_t RootMask = ~(~0ULL << RootScalePower) << LeafBlockPower;
@@ -106,6 +107,12 @@ public:
 
     const uint8_t * get_samples(uint64_t start_sample, uint64_t& end_sample, int sig_index, void **lbp=NULL);
 
+    // Get the samples of all decoder channels at start_sample with one lock,
+    // returns the end of the span. The channel of a flat block has NULL data and
+    // its level in consts, the span goes through the next blocks while all keep flat.
+    uint64_t get_decode_span(uint64_t start_sample, uint64_t end_sample, const int *sig_indexs,
+                    int num, const uint8_t **data, uint8_t *consts, void **lbps);
+
     bool get_sample(uint64_t index, int sig_index);
 
     void capture_ended();
@@ -126,10 +133,17 @@ public:
     int get_block_num();
     uint8_t *get_block_buf(int block_index, int sig_index, bool &sample);   
     uint64_t get_block_size(int block_index);
+
+    // The mipmap levels of a block, they follow its samples in the leaf block.
+    // NULL if the block has no data or does not start a leaf block.
+    const uint8_t *get_block_mipmap(int block_index, int sig_index, uint64_t &size);
     
     bool pattern_search(int64_t start, int64_t end, int64_t& index,
                         std::map<uint16_t, QString> &pattern, bool isNext);
 
+    bool find_idle_gap(uint64_t &index, uint64_t end, uint64_t min_length,
+                        const std::vector<int> &sig_indexs);
+
     inline void set_loop(bool bLoop){
         _is_loop = bLoop;
     }
@@ -156,6 +170,7 @@ private:
     int get_block_num_unlock();
     uint64_t get_block_size_unlock(int block_index);
     uint8_t *get_block_buf_unlock(int block_index, int sig_index, bool &sample);
+    const uint8_t * get_samples_unlock(uint64_t start_sample, uint64_t& end_sample, int sig_index, void **lbp);
     bool get_sample_unlock(uint64_t index, int sig_index);
     bool get_sample_self(uint64_t index, int sig_index);
 
@@ -170,12 +185,29 @@ private:
     bool pattern_search_self(int64_t start, int64_t end, int64_t& index,
                         std::map<uint16_t, QString> &pattern, bool isNext);
 
+    uint64_t get_sample_word_self(uint64_t word, int order);
+
+    bool is_span_constant(uint64_t index, unsigned int level, int order);
+
+    bool pattern_span_skip(uint64_t span_start, unsigned int level,
+                        const char *flags, const int *orders, int count, bool isNext);
+
+    uint64_t pattern_match_word(uint64_t word, const char *flags,
+                        const int *orders, int count, bool isNext);
+
+    bool find_idle_gap_self(uint64_t &index, uint64_t end, uint64_t min_length,
+                        const std::vector<int> &sig_indexs);
+
     int get_ch_order(int sig_index);
 
     void calc_mipmap(unsigned int order, uint8_t index0, uint8_t index1, uint64_t samples, bool isEnd);
 
+    void calc_root_bits(unsigned int order, uint8_t index0, uint8_t index1, uint64_t samples, bool isEnd);
+
     void append_cross_payload(const sr_datafeed_logic &logic);
 
+    void append_split_payload(const sr_datafeed_logic &logic);
+
     bool lbp_nxt_edge(uint64_t &index, uint64_t root_index, uint64_t lbp_tog, uint8_t lbp_tog_pos,
                       bool aft_tog, uint8_t aft_pos, bool last_sample, int sig_index);
 
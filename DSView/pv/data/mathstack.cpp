@@ -27,6 +27,8 @@
 #include  "../sigsession.h"
 #include  "../view/dsosignal.h"
 #include "../log.h"
+#include "samplekernel.h"
+#include <thread>
 
 #define PI 3.1415
 
@@ -40,6 +42,8 @@ const int MathStack::EnvelopeScalePower = 8;
 const int MathStack::EnvelopeScaleFactor = 1 << EnvelopeScalePower;
 const float MathStack::LogEnvelopeScaleFactor = logf(EnvelopeScaleFactor);
 const uint64_t MathStack::EnvelopeDataUnit = 4*1024;	// bytes
+const uint64_t MathStack::ParallelMinSamples = 256*1024;
+const int MathStack::ParallelMaxThreads = 4;
 
 const uint64_t MathStack::vDialValue[MathStack::vDialValueCount] = {
     1,
@@ -324,7 +328,7 @@ double MathStack::get_math_scale()
     return scale;
 }
 
-const double* MathStack::get_math(uint64_t start)
+const MathStack::MathValue* MathStack::get_math(uint64_t start)
 {
     return _math.data() + start;
 }
@@ -397,31 +401,52 @@ void MathStack::calc_math(uint64_t mathFactor)
     const int index2 = _dsoSig2->get_index();
     const uint8_t* value_buffer1 = data->get_samples(0, 0, index1);
     const uint8_t* value_buffer2 = data->get_samples(0, 0, index2);
-    double value1, value2;
 
-    for (uint64_t sample = 0; sample < _sample_num; sample++) {
-        value1 = *(value_buffer1 + sample);
-        value2 = *(value_buffer2 + sample);
+    MathCoeffs coeffs;
+    coeffs.scale1 = scale1;
+    coeffs.offset1 = delta1;
+    coeffs.scale2 = scale2;
+    coeffs.offset2 = delta2;
+    coeffs.factor = 1.0 / mathFactor;
 
-        switch(_type) 
-        {
-            case MATH_ADD:
-                _math[sample] = ((delta1 - scale1 * value1) + (delta2 - scale2 * value2)) / mathFactor;
-                break;
-            case MATH_SUB:
-                _math[sample] = ((delta1 - scale1 * value1) - (delta2 - scale2 * value2)) / mathFactor;
-                break;
-            case MATH_MUL:
-                _math[sample] = (delta1 - scale1 * value1) * (delta2 - scale2 * value2) / mathFactor;
-                break;
-            case MATH_DIV:
-                _math[sample] = (delta1 - scale1 * value1) / (delta2 - scale2 * value2) / mathFactor;
-                break;
-        }
+    // MathType has the order of MathKernelOp
+    const int op = (int)_type;
+
+    // The level 0 envelope is taken in the same pass
+    Envelope &e0 = _envelope_level[0];
+    MathValue *const envelope = _envelope_en ? (MathValue*)e0.samples : NULL;
+    if (_envelope_en) {
+        e0.length = _sample_num / EnvelopeScaleFactor;
+        reallocate_envelope(e0);
     }
 
-    if (_envelope_en)
-        append_to_envelope_level(true);
+    // The chunks are whole envelope samples, the threads do not share one
+    int threads = 1;
+    if (_sample_num >= ParallelMinSamples)
+        threads = max(1, min((int)std::thread::hardware_concurrency(), ParallelMaxThreads));
+    const uint64_t chunk = ((_sample_num / threads + EnvelopeScaleFactor - 1) /
+                            EnvelopeScaleFactor) * EnvelopeScaleFactor;
+
+    auto calc_chunk = [&](uint64_t start) {
+        const uint64_t count = min(chunk, _sample_num - start);
+        math_combine(value_buffer1 + start, value_buffer2 + start, count, op, coeffs,
+                     _math.data() + start,
+                     envelope ? envelope + 2 * (start / EnvelopeScaleFactor) : NULL,
+                     EnvelopeScaleFactor);
+    };
+
+    std::vector<std::thread> workers;
+    for (uint64_t start = chunk; start < _sample_num; start += chunk)
+        workers.push_back(std::thread(calc_chunk, start));
+    if (_sample_num > 0)
+        calc_chunk(0);
+    for (auto &th : workers)
+        th.join();
+
+    if (_envelope_en) {
+        append_envelope_levels();
+        _envelope_done = true;
+    }
 
     // stop
     _math_state = Stopped;
@@ -460,15 +485,15 @@ void MathStack::append_to_envelope_level(bool header)
     dest_ptr = e0.samples + prev_length;
 
     // Iterate through the samples to populate the first level mipmap
-    const double *const stop_src_ptr = (double*)_math.data() +
+    const MathValue *const stop_src_ptr = _math.data() +
         e0.length * EnvelopeScaleFactor;
-    for (const double *src_ptr = (double*)_math.data() +
+    for (const MathValue *src_ptr = _math.data() +
         prev_length * EnvelopeScaleFactor;
         src_ptr < stop_src_ptr; src_ptr += EnvelopeScaleFactor)
     {
-        const double * begin_src_ptr =
+        const MathValue * begin_src_ptr =
             src_ptr;
-        const double *const end_src_ptr =
+        const MathValue *const end_src_ptr =
             src_ptr + EnvelopeScaleFactor;
 
         EnvelopeSample sub_sample;
@@ -484,6 +509,16 @@ void MathStack::append_to_envelope_level(bool header)
         *dest_ptr++ = sub_sample;
     }
 
+    append_envelope_levels();
+
+    _envelope_done = true;
+}
+
+void MathStack::append_envelope_levels()
+{
+    uint64_t prev_length;
+    EnvelopeSample *dest_ptr;
+
     // Compute higher level mipmaps
     for (unsigned int level = 1; level < ScaleStepCount; level++)
     {
@@ -523,8 +558,6 @@ void MathStack::append_to_envelope_level(bool header)
             *dest_ptr = sub_sample;
         }
     }
-
-    _envelope_done = true;
 }
 
 } // namespace data
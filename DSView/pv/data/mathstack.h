@@ -63,10 +63,17 @@ public:
         MATH_DIV,
     };
 
+    // float halves the memory of the deep traces, DSV_MATH_DOUBLE keeps the doubles
+#ifdef DSV_MATH_DOUBLE
+    typedef double MathValue;
+#else
+    typedef float MathValue;
+#endif
+
     struct EnvelopeSample
     {
-        double min;
-        double max;
+        MathValue min;
+        MathValue max;
     };
 
     struct EnvelopeSection
@@ -91,6 +98,8 @@ private:
     static const int EnvelopeScaleFactor;
     static const float LogEnvelopeScaleFactor;
     static const uint64_t EnvelopeDataUnit;
+    static const uint64_t ParallelMinSamples;
+    static const int ParallelMaxThreads;
 
     static const uint64_t vDialValueStep = 1000;
     static const int vDialValueCount = 19;
@@ -122,7 +131,7 @@ public:
     QString get_unit(int level);
     double get_math_scale();
 
-    const double *get_math(uint64_t start);
+    const MathValue *get_math(uint64_t start);
     void get_math_envelope_section(EnvelopeSection &s,
         uint64_t start, uint64_t end, float min_length);
 
@@ -132,6 +141,9 @@ public:
 
 signals:
 
+private:
+    void append_envelope_levels();
+
 private:
     pv::SigSession  *_session;
     view::DsoSignal *_dsoSig1;
@@ -143,7 +155,7 @@ private:
     math_state _math_state;
 
     struct Envelope _envelope_level[ScaleStepCount];
-    std::vector<double> _math;
+    std::vector<MathValue> _math;
 
     bool _envelope_en;
     bool _envelope_done;
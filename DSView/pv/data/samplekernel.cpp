@@ -0,0 +1,806 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2022 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "samplekernel.h"
+#include <cstddef>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#define DSV_SAMPLE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DSV_SAMPLE_NEON
+#endif
+
+namespace pv {
+namespace data {
+
+namespace {
+
+#if defined(DSV_SAMPLE_SSE2)
+
+typedef __m128i vec_u8;
+
+inline vec_u8 vec_load(const uint8_t *p){
+    return _mm_loadu_si128((const __m128i*)p);
+}
+
+inline void vec_store(uint8_t *p, vec_u8 v){
+    _mm_storeu_si128((__m128i*)p, v);
+}
+
+inline vec_u8 vec_min(vec_u8 a, vec_u8 b){
+    return _mm_min_epu8(a, b);
+}
+
+inline vec_u8 vec_max(vec_u8 a, vec_u8 b){
+    return _mm_max_epu8(a, b);
+}
+
+// Move lane N to lane 0
+template<int N>
+inline vec_u8 vec_shift(vec_u8 v){
+    return _mm_srli_si128(v, N);
+}
+
+// Split 16 samples of two interleaved channels
+inline void vec_split2(const uint8_t *p, vec_u8 &a, vec_u8 &b)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    __m128i v0 = vec_load(p);
+    __m128i v1 = vec_load(p + 16);
+
+    a = _mm_packus_epi16(_mm_and_si128(v0, mask), _mm_and_si128(v1, mask));
+    b = _mm_packus_epi16(_mm_srli_epi16(v0, 8), _mm_srli_epi16(v1, 8));
+}
+
+inline vec_u8 vec_fill(uint8_t x){
+    return _mm_set1_epi8((char)x);
+}
+
+typedef __m128i vec_u32;
+
+inline vec_u32 vec_zero32(){
+    return _mm_setzero_si128();
+}
+
+inline uint64_t vec_hsum32(vec_u32 v)
+{
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, v);
+    return (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// Add the samples and their squares to the 32-bit lanes
+inline void vec_accumulate(vec_u8 v, vec_u32 &sum, vec_u32 &square)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+    sum = _mm_add_epi32(sum, _mm_sad_epu8(v, zero));
+    square = _mm_add_epi32(square, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+}
+
+#elif defined(DSV_SAMPLE_NEON)
+
+typedef uint8x16_t vec_u8;
+
+inline vec_u8 vec_load(const uint8_t *p){
+    return vld1q_u8(p);
+}
+
+inline void vec_store(uint8_t *p, vec_u8 v){
+    vst1q_u8(p, v);
+}
+
+inline vec_u8 vec_min(vec_u8 a, vec_u8 b){
+    return vminq_u8(a, b);
+}
+
+inline vec_u8 vec_max(vec_u8 a, vec_u8 b){
+    return vmaxq_u8(a, b);
+}
+
+template<int N>
+inline vec_u8 vec_shift(vec_u8 v){
+    return vextq_u8(v, vdupq_n_u8(0), N);
+}
+
+inline void vec_split2(const uint8_t *p, vec_u8 &a, vec_u8 &b)
+{
+    uint8x16x2_t v = vld2q_u8(p);
+    a = v.val[0];
+    b = v.val[1];
+}
+
+inline vec_u8 vec_fill(uint8_t x){
+    return vdupq_n_u8(x);
+}
+
+typedef uint32x4_t vec_u32;
+
+inline vec_u32 vec_zero32(){
+    return vdupq_n_u32(0);
+}
+
+inline uint64_t vec_hsum32(vec_u32 v)
+{
+    uint32_t lanes[4];
+    vst1q_u32(lanes, v);
+    return (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+inline void vec_accumulate(vec_u8 v, vec_u32 &sum, vec_u32 &square)
+{
+    sum = vpadalq_u16(sum, vpaddlq_u8(v));
+    square = vpadalq_u16(square, vmull_u8(vget_low_u8(v), vget_low_u8(v)));
+    square = vpadalq_u16(square, vmull_u8(vget_high_u8(v), vget_high_u8(v)));
+}
+
+#endif
+
+#if defined(DSV_SAMPLE_SSE2) || defined(DSV_SAMPLE_NEON)
+
+#define DSV_SAMPLE_SIMD
+
+// A 32-bit lane of the squares grows at most 4 * 255 * 255 per 16 samples
+const uint64_t StatsFlushSamples = 16 * 4096;
+
+// Lane-wise min and max of the 16-byte blocks, bytes is a multiple of 16
+inline void vec_minmax(const uint8_t *p, int bytes, vec_u8 &mn, vec_u8 &mx)
+{
+    int i;
+
+#ifdef __AVX2__
+    if (bytes % 32 == 0) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)p);
+        __m256i b = a;
+
+        for (i = 32; i < bytes; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+            a = _mm256_min_epu8(a, v);
+            b = _mm256_max_epu8(b, v);
+        }
+
+        mn = _mm_min_epu8(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+        mx = _mm_max_epu8(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1));
+        return;
+    }
+#endif
+
+    mn = vec_load(p);
+    mx = mn;
+
+    for (i = 16; i < bytes; i += 16) {
+        vec_u8 v = vec_load(p + i);
+        mn = vec_min(mn, v);
+        mx = vec_max(mx, v);
+    }
+}
+
+// The lanes repeat every Stride bytes, fold them into the first Stride lanes
+template<int Stride>
+inline void vec_fold(vec_u8 &mn, vec_u8 &mx)
+{
+    if (Stride <= 8) {
+        mn = vec_min(mn, vec_shift<8>(mn));
+        mx = vec_max(mx, vec_shift<8>(mx));
+    }
+    if (Stride <= 4) {
+        mn = vec_min(mn, vec_shift<4>(mn));
+        mx = vec_max(mx, vec_shift<4>(mx));
+    }
+    if (Stride <= 2) {
+        mn = vec_min(mn, vec_shift<2>(mn));
+        mx = vec_max(mx, vec_shift<2>(mx));
+    }
+    if (Stride <= 1) {
+        mn = vec_min(mn, vec_shift<1>(mn));
+        mx = vec_max(mx, vec_shift<1>(mx));
+    }
+}
+
+template<int Stride>
+void envelope_interleaved_simd(const uint8_t *src, uint64_t groups, int group_bytes,
+                               int channels, int unit_bytes, uint8_t *const *dest)
+{
+    uint8_t lanes_min[16];
+    uint8_t lanes_max[16];
+
+    for (uint64_t g = 0; g < groups; g++) {
+        vec_u8 mn, mx;
+
+        vec_minmax(src, group_bytes, mn, mx);
+        vec_fold<Stride>(mn, mx);
+        vec_store(lanes_min, mn);
+        vec_store(lanes_max, mx);
+
+        for (int ch = 0; ch < channels; ch++) {
+            dest[ch][2*g] = lanes_min[ch * unit_bytes];
+            dest[ch][2*g + 1] = lanes_max[ch * unit_bytes];
+        }
+        src += group_bytes;
+    }
+}
+
+#endif
+
+// The float lanes of the math kernel
+#if defined(DSV_SAMPLE_SSE2)
+
+#define DSV_MATH_SIMD
+
+typedef __m128 vec_f32;
+
+// 16 samples to 4 float vectors
+inline void vec_load_u8f(const uint8_t *p, vec_f32 *f)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+    f[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+    f[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+    f[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+    f[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+}
+
+inline vec_f32 vec_set1f(float x){ return _mm_set1_ps(x); }
+inline vec_f32 vec_addf(vec_f32 a, vec_f32 b){ return _mm_add_ps(a, b); }
+inline vec_f32 vec_subf(vec_f32 a, vec_f32 b){ return _mm_sub_ps(a, b); }
+inline vec_f32 vec_mulf(vec_f32 a, vec_f32 b){ return _mm_mul_ps(a, b); }
+inline vec_f32 vec_divf(vec_f32 a, vec_f32 b){ return _mm_div_ps(a, b); }
+inline vec_f32 vec_minf(vec_f32 a, vec_f32 b){ return _mm_min_ps(a, b); }
+inline vec_f32 vec_maxf(vec_f32 a, vec_f32 b){ return _mm_max_ps(a, b); }
+inline void vec_storef(float *p, vec_f32 v){ _mm_storeu_ps(p, v); }
+inline vec_f32 vec_loadf(const float *p){ return _mm_loadu_ps(p); }
+inline vec_f32 vec_zero_below(vec_f32 v, vec_f32 lo){ return _mm_and_ps(v, _mm_cmpge_ps(v, lo)); }
+
+#elif defined(DSV_SAMPLE_NEON)
+
+#define DSV_MATH_SIMD
+
+typedef float32x4_t vec_f32;
+
+inline void vec_load_u8f(const uint8_t *p, vec_f32 *f)
+{
+    uint8x16_t v = vld1q_u8(p);
+    uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+    uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+
+    f[0] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo)));
+    f[1] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo)));
+    f[2] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi)));
+    f[3] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi)));
+}
+
+inline vec_f32 vec_set1f(float x){ return vdupq_n_f32(x); }
+inline vec_f32 vec_addf(vec_f32 a, vec_f32 b){ return vaddq_f32(a, b); }
+inline vec_f32 vec_subf(vec_f32 a, vec_f32 b){ return vsubq_f32(a, b); }
+inline vec_f32 vec_mulf(vec_f32 a, vec_f32 b){ return vmulq_f32(a, b); }
+inline vec_f32 vec_minf(vec_f32 a, vec_f32 b){ return vminq_f32(a, b); }
+inline vec_f32 vec_maxf(vec_f32 a, vec_f32 b){ return vmaxq_f32(a, b); }
+inline void vec_storef(float *p, vec_f32 v){ vst1q_f32(p, v); }
+inline vec_f32 vec_loadf(const float *p){ return vld1q_f32(p); }
+inline vec_f32 vec_zero_below(vec_f32 v, vec_f32 lo)
+{
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), vcgeq_f32(v, lo)));
+}
+
+inline vec_f32 vec_divf(vec_f32 a, vec_f32 b)
+{
+#ifdef __aarch64__
+    return vdivq_f32(a, b);
+#else
+    // ARMv7 has no divide, two Newton steps of the reciprocal estimate
+    vec_f32 r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+#endif
+}
+
+#endif
+
+// Op is a constant, the switch is resolved when the template is built
+template<int Op, typename T>
+inline T math_value(T a, T b)
+{
+    switch (Op) {
+    case MathKernelAdd: return a + b;
+    case MathKernelSub: return a - b;
+    case MathKernelMul: return a * b;
+    default:            return a / b;
+    }
+}
+
+// k holds scale1, offset1, scale2, offset2 and factor
+template<int Op, typename T>
+void math_block_scalar(const uint8_t *src1, const uint8_t *src2, uint64_t n,
+                       const T *k, T *dest, T &mn, T &mx)
+{
+    for (uint64_t i = 0; i < n; i++) {
+        const T v = math_value<Op, T>(k[1] - k[0] * src1[i], k[3] - k[2] * src2[i]) * k[4];
+        dest[i] = v;
+        mn = (v < mn) ? v : mn;
+        mx = (v > mx) ? v : mx;
+    }
+}
+
+template<int Op>
+inline void math_block(const uint8_t *src1, const uint8_t *src2, uint64_t n,
+                       const double *k, double *dest, double &mn, double &mx)
+{
+    math_block_scalar<Op, double>(src1, src2, n, k, dest, mn, mx);
+}
+
+#ifdef DSV_MATH_SIMD
+
+template<int Op>
+inline vec_f32 math_vec(vec_f32 a, vec_f32 b)
+{
+    switch (Op) {
+    case MathKernelAdd: return vec_addf(a, b);
+    case MathKernelSub: return vec_subf(a, b);
+    case MathKernelMul: return vec_mulf(a, b);
+    default:            return vec_divf(a, b);
+    }
+}
+
+template<int Op>
+void math_block(const uint8_t *src1, const uint8_t *src2, uint64_t n,
+                const float *k, float *dest, float &mn, float &mx)
+{
+    uint64_t i = 0;
+
+    if (n >= 16) {
+        const vec_f32 s1 = vec_set1f(k[0]);
+        const vec_f32 o1 = vec_set1f(k[1]);
+        const vec_f32 s2 = vec_set1f(k[2]);
+        const vec_f32 o2 = vec_set1f(k[3]);
+        const vec_f32 f = vec_set1f(k[4]);
+        vec_f32 vmn = vec_set1f(mn);
+        vec_f32 vmx = vec_set1f(mx);
+
+        for (; i + 16 <= n; i += 16) {
+            vec_f32 a[4], b[4];
+            vec_load_u8f(src1 + i, a);
+            vec_load_u8f(src2 + i, b);
+
+            for (int j = 0; j < 4; j++) {
+                const vec_f32 v = vec_mulf(math_vec<Op>(vec_subf(o1, vec_mulf(s1, a[j])),
+                                                        vec_subf(o2, vec_mulf(s2, b[j]))), f);
+                vec_storef(dest + i + 4*j, v);
+                vmn = vec_minf(vmn, v);
+                vmx = vec_maxf(vmx, v);
+            }
+        }
+
+        float lanes_min[4];
+        float lanes_max[4];
+        vec_storef(lanes_min, vmn);
+        vec_storef(lanes_max, vmx);
+        for (int j = 0; j < 4; j++) {
+            mn = (lanes_min[j] < mn) ? lanes_min[j] : mn;
+            mx = (lanes_max[j] > mx) ? lanes_max[j] : mx;
+        }
+    }
+
+    math_block_scalar<Op, float>(src1 + i, src2 + i, n - i, k, dest + i, mn, mx);
+}
+
+#else
+
+template<int Op>
+inline void math_block(const uint8_t *src1, const uint8_t *src2, uint64_t n,
+                       const float *k, float *dest, float &mn, float &mx)
+{
+    math_block_scalar<Op, float>(src1, src2, n, k, dest, mn, mx);
+}
+
+#endif
+
+template<int Op, typename T>
+void math_combine_op(const uint8_t *src1, const uint8_t *src2, uint64_t count,
+                     const T *k, T *dest, T *envelope, int group_size)
+{
+    uint64_t i = 0;
+    T mn, mx;
+
+    if (envelope) {
+        const uint64_t groups = count / group_size;
+        for (uint64_t g = 0; g < groups; g++, i += group_size) {
+            mn = std::numeric_limits<T>::infinity();
+            mx = -std::numeric_limits<T>::infinity();
+            math_block<Op>(src1 + i, src2 + i, group_size, k, dest + i, mn, mx);
+            envelope[2*g] = mn;
+            envelope[2*g + 1] = mx;
+        }
+    }
+
+    if (i < count)
+        math_block<Op>(src1 + i, src2 + i, count - i, k, dest + i, mn, mx);
+}
+
+template<typename T>
+void math_combine_typed(const uint8_t *src1, const uint8_t *src2, uint64_t count, int op,
+                        const MathCoeffs &c, T *dest, T *envelope, int group_size)
+{
+    const T k[5] = {(T)c.scale1, (T)c.offset1, (T)c.scale2, (T)c.offset2, (T)c.factor};
+
+    switch (op) {
+    case MathKernelAdd:
+        math_combine_op<MathKernelAdd, T>(src1, src2, count, k, dest, envelope, group_size);
+        break;
+    case MathKernelSub:
+        math_combine_op<MathKernelSub, T>(src1, src2, count, k, dest, envelope, group_size);
+        break;
+    case MathKernelMul:
+        math_combine_op<MathKernelMul, T>(src1, src2, count, k, dest, envelope, group_size);
+        break;
+    case MathKernelDiv:
+        math_combine_op<MathKernelDiv, T>(src1, src2, count, k, dest, envelope, group_size);
+        break;
+    }
+}
+
+// Transposes the 8x8 bit matrix of x, bit c of byte r goes to bit r of byte c
+inline uint64_t transpose8x8(uint64_t x)
+{
+    uint64_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+#if defined(DSV_SAMPLE_SSE2)
+
+// The same on both 64-bit lanes
+inline __m128i transpose8x8_x2(__m128i x)
+{
+    __m128i t;
+
+    t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 7)), _mm_set1_epi64x(0x00AA00AA00AA00AALL));
+    x = _mm_xor_si128(_mm_xor_si128(x, t), _mm_slli_epi64(t, 7));
+    t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 14)), _mm_set1_epi64x(0x0000CCCC0000CCCCLL));
+    x = _mm_xor_si128(_mm_xor_si128(x, t), _mm_slli_epi64(t, 14));
+    t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 28)), _mm_set1_epi64x(0x00000000F0F0F0F0LL));
+    x = _mm_xor_si128(_mm_xor_si128(x, t), _mm_slli_epi64(t, 28));
+    return x;
+}
+
+#endif
+
+// The byte of 8 channels for each sample, a NULL row has no bit set
+void transpose_group(const uint8_t *const *rows, uint8_t const_bits, uint64_t samples,
+                     int unit_size, uint8_t *out)
+{
+    const uint64_t whole = samples / 8;
+    uint64_t b = 0;
+
+#if defined(DSV_SAMPLE_SSE2)
+    const __m128i low = _mm_set1_epi16(0x00ff);
+
+    for (; b + 2 <= whole; b += 2) {
+        uint16_t w[8];
+        for (int r = 0; r < 8; r++)
+            w[r] = rows[r] ? (uint16_t)(rows[r][b] | (rows[r][b + 1] << 8)) : 0;
+
+        // Byte r of a lane is row r, the low lane takes the first byte of the rows
+        const __m128i v = _mm_loadu_si128((const __m128i*)w);
+        const __m128i x = _mm_packus_epi16(_mm_and_si128(v, low), _mm_srli_epi16(v, 8));
+
+        uint8_t t[16];
+        _mm_storeu_si128((__m128i*)t, transpose8x8_x2(x));
+
+        uint8_t *const o = out + b * 8 * unit_size;
+        for (int j = 0; j < 16; j++)
+            o[j * unit_size] = t[j] | const_bits;
+    }
+#endif
+
+    for (; b < whole; b++) {
+        uint64_t x = 0;
+        for (int r = 0; r < 8; r++) {
+            if (rows[r])
+                x |= (uint64_t)rows[r][b] << (8 * r);
+        }
+        x = transpose8x8(x);
+
+        uint8_t *const o = out + b * 8 * unit_size;
+        for (int j = 0; j < 8; j++, x >>= 8)
+            o[j * unit_size] = (uint8_t)x | const_bits;
+    }
+
+    for (uint64_t j = whole * 8; j < samples; j++) {
+        uint8_t v = const_bits;
+        for (int r = 0; r < 8; r++) {
+            if (rows[r] && (rows[r][j / 8] & (1 << (j % 8))))
+                v |= 1 << r;
+        }
+        out[j * unit_size] = v;
+    }
+}
+
+} // namespace
+
+void envelope_contiguous(const uint8_t *src, uint64_t groups, int group_size, uint8_t *dest)
+{
+#ifdef DSV_SAMPLE_SIMD
+    if (group_size % 16 == 0) {
+        envelope_interleaved_simd<1>(src, groups, group_size, 1, 1, &dest);
+        return;
+    }
+#endif
+
+    for (uint64_t g = 0; g < groups; g++) {
+        const uint8_t *const end = src + group_size;
+        uint8_t mn = *src;
+        uint8_t mx = *src;
+
+        for (src++; src < end; src++) {
+            mn = (*src < mn) ? *src : mn;
+            mx = (*src > mx) ? *src : mx;
+        }
+        *dest++ = mn;
+        *dest++ = mx;
+    }
+}
+
+void envelope_interleaved(const uint8_t *src, uint64_t groups, int group_size,
+                          int channels, int unit_bytes, uint8_t *const *dest)
+{
+    const int stride = channels * unit_bytes;
+
+#ifdef DSV_SAMPLE_SIMD
+    // The lanes of a block map to the same channels when the stride divides it
+    const int group_bytes = group_size * stride;
+
+    if (16 % stride == 0 && group_bytes % 16 == 0) {
+        switch (stride) {
+        case 1:
+            envelope_interleaved_simd<1>(src, groups, group_bytes, channels, unit_bytes, dest);
+            return;
+        case 2:
+            envelope_interleaved_simd<2>(src, groups, group_bytes, channels, unit_bytes, dest);
+            return;
+        case 4:
+            envelope_interleaved_simd<4>(src, groups, group_bytes, channels, unit_bytes, dest);
+            return;
+        case 8:
+            envelope_interleaved_simd<8>(src, groups, group_bytes, channels, unit_bytes, dest);
+            return;
+        default:
+            envelope_interleaved_simd<16>(src, groups, group_bytes, channels, unit_bytes, dest);
+            return;
+        }
+    }
+#endif
+
+    for (int ch = 0; ch < channels; ch++) {
+        const uint8_t *p = src + ch * unit_bytes;
+        uint8_t *d = dest[ch];
+
+        for (uint64_t g = 0; g < groups; g++) {
+            uint8_t mn = *p;
+            uint8_t mx = *p;
+
+            p += stride;
+            for (int i = 1; i < group_size; i++) {
+                mn = (*p < mn) ? *p : mn;
+                mx = (*p > mx) ? *p : mx;
+                p += stride;
+            }
+            *d++ = mn;
+            *d++ = mx;
+        }
+    }
+}
+
+void deinterleave(const uint8_t *src, uint64_t samples, int channels,
+                  uint8_t *const *dest, SampleStats *stats)
+{
+    uint64_t i = 0;
+
+#ifdef DSV_SAMPLE_SIMD
+    if (channels == 1 || channels == 2) {
+        const uint64_t simd_end = samples & ~15ULL;
+        uint8_t lanes_min[16];
+        uint8_t lanes_max[16];
+        vec_u8 vmn[2];
+        vec_u8 vmx[2];
+        vec_u32 sum[2];
+        vec_u32 square[2];
+
+        for (int ch = 0; ch < channels; ch++) {
+            vmn[ch] = vec_fill(0xff);
+            vmx[ch] = vec_fill(0);
+        }
+
+        while (i < simd_end) {
+            // Empty the 32-bit lanes before they overflow
+            const uint64_t end = (simd_end - i > StatsFlushSamples) ? i + StatsFlushSamples : simd_end;
+
+            for (int ch = 0; ch < channels; ch++) {
+                sum[ch] = vec_zero32();
+                square[ch] = vec_zero32();
+            }
+
+            if (channels == 1) {
+                for (; i < end; i += 16) {
+                    vec_u8 v = vec_load(src + i);
+                    vec_store(dest[0] + i, v);
+                    vmn[0] = vec_min(vmn[0], v);
+                    vmx[0] = vec_max(vmx[0], v);
+                    vec_accumulate(v, sum[0], square[0]);
+                }
+            }
+            else {
+                for (; i < end; i += 16) {
+                    vec_u8 a, b;
+                    vec_split2(src + 2 * i, a, b);
+                    vec_store(dest[0] + i, a);
+                    vec_store(dest[1] + i, b);
+                    vmn[0] = vec_min(vmn[0], a);
+                    vmx[0] = vec_max(vmx[0], a);
+                    vec_accumulate(a, sum[0], square[0]);
+                    vmn[1] = vec_min(vmn[1], b);
+                    vmx[1] = vec_max(vmx[1], b);
+                    vec_accumulate(b, sum[1], square[1]);
+                }
+            }
+
+            for (int ch = 0; ch < channels; ch++) {
+                stats[ch].sum += vec_hsum32(sum[ch]);
+                stats[ch].square_sum += vec_hsum32(square[ch]);
+            }
+        }
+
+        for (int ch = 0; ch < channels && simd_end > 0; ch++) {
+            vec_fold<1>(vmn[ch], vmx[ch]);
+            vec_store(lanes_min, vmn[ch]);
+            vec_store(lanes_max, vmx[ch]);
+            stats[ch].min = (lanes_min[0] < stats[ch].min) ? lanes_min[0] : stats[ch].min;
+            stats[ch].max = (lanes_max[0] > stats[ch].max) ? lanes_max[0] : stats[ch].max;
+        }
+    }
+#endif
+
+    for (; i < samples; i++) {
+        for (int ch = 0; ch < channels; ch++) {
+            const uint8_t v = src[i * channels + ch];
+            SampleStats &s = stats[ch];
+
+            dest[ch][i] = v;
+            s.min = (v < s.min) ? v : s.min;
+            s.max = (v > s.max) ? v : s.max;
+            s.sum += v;
+            s.square_sum += (uint32_t)v * v;
+        }
+    }
+}
+
+void math_combine(const uint8_t *src1, const uint8_t *src2, uint64_t count, int op,
+                  const MathCoeffs &c, float *dest, float *envelope, int group_size)
+{
+    math_combine_typed<float>(src1, src2, count, op, c, dest, envelope, group_size);
+}
+
+void math_combine(const uint8_t *src1, const uint8_t *src2, uint64_t count, int op,
+                  const MathCoeffs &c, double *dest, double *envelope, int group_size)
+{
+    math_combine_typed<double>(src1, src2, count, op, c, dest, envelope, group_size);
+}
+
+void transpose_bits(const uint8_t *const *src, const uint8_t *fill, int channels,
+                    uint64_t samples, int unit_size, uint8_t *dest)
+{
+    for (int g = 0; g < unit_size; g++) {
+        const uint8_t *rows[8];
+        uint8_t const_bits = 0;
+        bool live = false;
+
+        for (int r = 0; r < 8; r++) {
+            const int k = g * 8 + r;
+
+            rows[r] = (k < channels) ? src[k] : NULL;
+            if (k < channels && src[k] == NULL && fill[k])
+                const_bits |= 1 << r;
+            live = live || rows[r];
+        }
+
+        uint8_t *const out = dest + g;
+
+        if (live) {
+            transpose_group(rows, const_bits, samples, unit_size, out);
+        }
+        else {
+            // Constant channels only, nothing to transpose
+            for (uint64_t j = 0; j < samples; j++)
+                out[j * unit_size] = const_bits;
+        }
+    }
+}
+
+float hits_add(float *dest, int count, float weight)
+{
+    float mx = 0;
+    int i = 0;
+
+#ifdef DSV_MATH_SIMD
+    if (count >= 8) {
+        const vec_f32 w = vec_set1f(weight);
+        vec_f32 vmx = vec_set1f(0);
+
+        for (; i + 4 <= count; i += 4) {
+            const vec_f32 v = vec_addf(vec_loadf(dest + i), w);
+            vec_storef(dest + i, v);
+            vmx = vec_maxf(vmx, v);
+        }
+
+        float lanes[4];
+        vec_storef(lanes, vmx);
+        for (int j = 0; j < 4; j++)
+            mx = (lanes[j] > mx) ? lanes[j] : mx;
+    }
+#endif
+
+    for (; i < count; i++) {
+        dest[i] += weight;
+        mx = (dest[i] > mx) ? dest[i] : mx;
+    }
+
+    return mx;
+}
+
+void hits_scale(float *dest, uint64_t count, float factor, float min_value)
+{
+    uint64_t i = 0;
+
+#ifdef DSV_MATH_SIMD
+    const vec_f32 f = vec_set1f(factor);
+    const vec_f32 lo = vec_set1f(min_value);
+
+    for (; i + 4 <= count; i += 4) {
+        const vec_f32 v = vec_mulf(vec_loadf(dest + i), f);
+        vec_storef(dest + i, vec_zero_below(v, lo));
+    }
+#endif
+
+    for (; i < count; i++) {
+        const float v = dest[i] * factor;
+        dest[i] = (v < min_value) ? 0 : v;
+    }
+}
+
+} // namespace data
+} // namespace pv
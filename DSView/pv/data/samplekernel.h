@@ -0,0 +1,129 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2022 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef DSVIEW_PV_DATA_SAMPLEKERNEL_H
+#define DSVIEW_PV_DATA_SAMPLEKERNEL_H
+
+#include <stdint.h>
+
+namespace pv {
+namespace data {
+
+/*
+ * The vectorized loops over the raw 8-bit samples of the analog and dso snapshots.
+ * SSE2/AVX2 or NEON is used when the compiler targets it, the others run the scalar code.
+ */
+
+/*
+ * Min and max of each group of group_size contiguous samples.
+ * dest receives one {min, max} byte pair per group.
+ */
+void envelope_contiguous(const uint8_t *src, uint64_t groups, int group_size, uint8_t *dest);
+
+/*
+ * Min and max of each group of group_size samples of the interleaved channels.
+ * A sample of a channel is unit_bytes wide, the first byte is the value.
+ * dest[ch] receives one {min, max} byte pair per group.
+ */
+void envelope_interleaved(const uint8_t *src, uint64_t groups, int group_size,
+                          int channels, int unit_bytes, uint8_t *const *dest);
+
+struct SampleStats
+{
+    uint8_t  min;
+    uint8_t  max;
+    uint64_t sum;
+    uint64_t square_sum;
+
+    SampleStats(){
+        clear();
+    }
+
+    inline void clear(){
+        min = 0xff;
+        max = 0;
+        sum = 0;
+        square_sum = 0;
+    }
+
+    inline void add(const SampleStats &s){
+        min = (s.min < min) ? s.min : min;
+        max = (s.max > max) ? s.max : max;
+        sum += s.sum;
+        square_sum += s.square_sum;
+    }
+};
+
+/*
+ * Copy the interleaved 8-bit samples to dest[ch], one pass.
+ * stats[ch] accumulates the range, the sum and the square sum of the channel.
+ */
+void deinterleave(const uint8_t *src, uint64_t samples, int channels,
+                  uint8_t *const *dest, SampleStats *stats);
+
+enum MathKernelOp {
+    MathKernelAdd,
+    MathKernelSub,
+    MathKernelMul,
+    MathKernelDiv
+};
+
+struct MathCoeffs
+{
+    double scale1;
+    double offset1;
+    double scale2;
+    double offset2;
+    double factor;
+};
+
+/*
+ * dest[i] = op(offset1 - scale1 * src1[i], offset2 - scale2 * src2[i]) * factor
+ * If envelope is not NULL, it receives one {min, max} pair per whole group of group_size values.
+ * The float version runs on SSE2/NEON, the double one is the scalar loop.
+ */
+void math_combine(const uint8_t *src1, const uint8_t *src2, uint64_t count, int op,
+                  const MathCoeffs &c, float *dest, float *envelope, int group_size);
+void math_combine(const uint8_t *src1, const uint8_t *src2, uint64_t count, int op,
+                  const MathCoeffs &c, double *dest, double *envelope, int group_size);
+
+/*
+ * Interleaves the packed bits of the channels into units of unit_size bytes:
+ * sample j of channel k is bit j%8 of src[k][j/8], it goes to bit k%8 of dest[j*unit_size + k/8].
+ * A NULL src[k] is a constant channel, all its samples are fill[k].
+ */
+void transpose_bits(const uint8_t *const *src, const uint8_t *fill, int channels,
+                    uint64_t samples, int unit_size, uint8_t *dest);
+
+/*
+ * dest[i] += weight over count values, returns the largest of the sums.
+ */
+float hits_add(float *dest, int count, float weight);
+
+/*
+ * dest[i] *= factor, the results below min_value are set to 0.
+ */
+void hits_scale(float *dest, uint64_t count, float factor, float min_value);
+
+} // namespace data
+} // namespace pv
+
+#endif // DSVIEW_PV_DATA_SAMPLEKERNEL_H
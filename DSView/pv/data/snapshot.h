@@ -39,7 +39,7 @@ public:
     virtual void clear() = 0;
     virtual void init() = 0;
 
-	uint64_t get_sample_count();
+	virtual uint64_t get_sample_count();
     uint64_t get_total_sample_count();
     uint64_t get_ring_sample_count();
     uint64_t get_ring_start();
@@ -21,10 +21,14 @@
 
 #include "spectrumstack.h"
 #include <math.h>
+#include <algorithm>
 #include "dsosnapshot.h"
 #include "../sigsession.h"
 #include "../view/dsosignal.h"
 #include "../ui/langresource.h"
+#include "../config/appconfig.h"
+#include "../utility/path.h"
+#include "../log.h"
 
 
 #define PI 3.1415
@@ -35,24 +39,79 @@ using namespace std;
 namespace pv {
 namespace data {
 
+// Transforms from this length on are planned on several threads
+const uint64_t FftThreadsMinSamples = 256*1024;
+const int FftMaxThreads = 4;
+
+// The fftw planner is not thread safe, all the stacks share it
+static std::mutex g_planner_mutex;
+static bool g_wisdom_loaded = false;
+static bool g_wisdom_added = false; // not exported yet
+
+static std::string fft_wisdom_path()
+{
+    return pv::path::ToUnicodePath(GetUserDataDir() + "/fftw_wisdom");
+}
+
+const int SpectrumStack::SpectrogramDepth = 128;
+
 SpectrumStack::SpectrumStack(pv::SigSession *session, int index) :
     _session(session),
     _index(index),
+    _sample_num(0),
+    _windows_index(0),
     _dc_ignore(true),
     _sample_interval(1),
     _spectrum_state(Init),
-    _fft_plan(NULL)
+    _calc_mode(SingleFrame),
+    _average_mode(NoAverage),
+    _average_count(16),
+    _average_reset(true),
+    _thread_exit(false),
+    _input_ready(false),
+    _input_sample_num(0),
+    _input_windows_index(0),
+    _input_calc_mode(SingleFrame),
+    _input_average_mode(NoAverage),
+    _input_average_count(16),
+    _fft_plan(NULL),
+    _plan_sample_num(0),
+    _window_sample_num(0),
+    _window_type(-1),
+    _window_sum(0),
+    _avg_frames(0),
+    _avg_head(0),
+    _spectrogram_bins(0),
+    _spectrogram_head(0),
+    _spectrogram_rows(0)
 {
 
 }
 
 SpectrumStack::~SpectrumStack()
 {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _thread_exit = true;
+    }
+    _cond.notify_one();
+    if (_thread.joinable())
+        _thread.join();
+
     _xn.clear();
     _xk.clear();
     _power_spectrum.clear();
-    if (_fft_plan)
+    if (_fft_plan) {
+        std::lock_guard<std::mutex> lock(g_planner_mutex);
         fftw_destroy_plan(_fft_plan);
+
+        // The plans measured by this stack are kept for the next run
+        if (g_wisdom_added) {
+            g_wisdom_added = false;
+            if (!fftw_export_wisdom_to_filename(fft_wisdom_path().c_str()))
+                dsv_err("Failed to save the fft wisdom.");
+        }
+    }
 }
 
 void SpectrumStack::clear()
@@ -75,12 +134,17 @@ uint64_t SpectrumStack::get_sample_num()
 
 void SpectrumStack::set_sample_num(uint64_t num)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (num == _sample_num)
+        return;
+
+    // The plan is built again by the worker, on the next calculation
     _sample_num = num;
-    _xn.resize(_sample_num);
-    _xk.resize(_sample_num);
-    _power_spectrum.resize(_sample_num/2+1);
-    _fft_plan = fftw_plan_r2r_1d(_sample_num, _xn.data(), _xk.data(),
-                                 FFTW_R2HC, FFTW_ESTIMATE);
+    _input_ready = false;
+    _power_spectrum.clear();
+    _spectrum_state = Init;
+    reset_average_unlock();
 }
 
 int SpectrumStack::get_windows_index()
@@ -90,6 +154,10 @@ int SpectrumStack::get_windows_index()
 
 void SpectrumStack::set_windows_index(int index)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (index != _windows_index)
+        reset_average_unlock();
     _windows_index = index;
 }
 
@@ -110,30 +178,110 @@ int SpectrumStack::get_sample_interval()
 
 void SpectrumStack::set_sample_interval(int interval)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (interval != _sample_interval)
+        reset_average_unlock();
     _sample_interval = interval;
 }
 
+int SpectrumStack::get_calc_mode()
+{
+    return _calc_mode;
+}
+
+void SpectrumStack::set_calc_mode(int mode)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (mode != _calc_mode)
+        reset_average_unlock();
+    _calc_mode = mode;
+}
+
+int SpectrumStack::get_average_mode()
+{
+    return _average_mode;
+}
+
+void SpectrumStack::set_average_mode(int mode)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (mode != _average_mode)
+        reset_average_unlock();
+    _average_mode = mode;
+}
+
+int SpectrumStack::get_average_count()
+{
+    return _average_count;
+}
+
+void SpectrumStack::set_average_count(int count)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    count = max(count, 1);
+    if (count != _average_count)
+        reset_average_unlock();
+    _average_count = count;
+}
+
+void SpectrumStack::reset_average()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    reset_average_unlock();
+}
+
+void SpectrumStack::reset_average_unlock()
+{
+    // The worker drops its frames before the next one
+    _average_reset = true;
+    _spectrogram.clear();
+    _spectrogram_bins = 0;
+    _spectrogram_head = 0;
+    _spectrogram_rows = 0;
+}
+
 const std::vector<double> SpectrumStack::get_fft_spectrum()
 {
-    std::vector<double> empty;
-    if (_spectrum_state == Stopped)
-        return _power_spectrum;
-    else
-        return empty;
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _power_spectrum;
 }
 
 double SpectrumStack::get_fft_spectrum(uint64_t index)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
+
     double ret = -1;
-    if (_spectrum_state == Stopped && index < _power_spectrum.size())
+    if (index < _power_spectrum.size())
         ret = _power_spectrum[index];
 
     return ret;
 }
 
+bool SpectrumStack::get_spectrogram(std::vector<float> &rows, uint64_t &bins, int &row_count)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    bins = _spectrogram_bins;
+    row_count = _spectrogram_rows;
+    rows.resize(bins * row_count);
+    if (row_count == 0)
+        return false;
+
+    // Unroll the ring, the oldest row is the one after the head
+    const int first = (_spectrogram_head + SpectrogramDepth - row_count) % SpectrogramDepth;
+    for (int r = 0; r < row_count; r++) {
+        const float *src = _spectrogram.data() + ((first + r) % SpectrogramDepth) * bins;
+        std::copy(src, src + bins, rows.begin() + r * bins);
+    }
+    return true;
+}
+
 void SpectrumStack::calc_fft()
 {
-    _spectrum_state = Running;
     // Get the dso data
     pv::data::DsoSnapshot *data = NULL;
     pv::view::DsoSignal *dsoSig = NULL;
@@ -148,7 +296,7 @@ void SpectrumStack::calc_fft()
         }
     }
 
-    if (data == NULL || data->empty())
+    if (data == NULL || data->empty() || _sample_num == 0)
         return;
 
     if (data->get_sample_count() < _sample_num * _sample_interval)
@@ -159,35 +307,238 @@ void SpectrumStack::calc_fft()
     if (_samplerate == 0.0)
         _samplerate = 1.0;
 
-    // prepare _xn data
+    // Welch's method takes the segments of the whole frame
+    uint64_t input_num = _sample_num;
+    if (_calc_mode == Welch)
+        input_num = data->get_sample_count() / _sample_interval;
+
+    // prepare the input of the worker, the window is applied there
     const int offset = dsoSig->get_hw_offset();
     const double vscale = dsoSig->get_vDialValue() * dsoSig->get_factor() * DS_CONF_DSO_VDIVS / (1000*255.0);
     const uint16_t step = _sample_interval;
-    const uint8_t *const samples = data->get_samples(0, _sample_num*_sample_interval-1, _index);
-    double wsum = 0;
-    
-    for (unsigned int i = 0; i < _sample_num; i++) {
-        double w = window(i, _windows_index);
-        _xn[i] = (samples[i*step] - offset) * vscale * w;
-        wsum += w;
+    const uint8_t *const samples = data->get_samples(0, input_num*_sample_interval-1, _index);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _input.resize(input_num);
+        for (uint64_t i = 0; i < input_num; i++)
+            _input[i] = (samples[i*step] - offset) * vscale;
+        _input_sample_num = _sample_num;
+        _input_windows_index = _windows_index;
+        _input_calc_mode = _calc_mode;
+        _input_average_mode = _average_mode;
+        _input_average_count = _average_count;
+        _input_ready = true;
+        _spectrum_state = Running;
+
+        if (!_thread.joinable())
+            _thread = std::thread(&SpectrumStack::fft_proc, this);
     }
+    _cond.notify_one();
+}
 
-    // fft
-    fftw_execute(_fft_plan);
+void SpectrumStack::fft_proc()
+{
+    std::vector<double> input;
+    std::vector<double> power_spectrum;
+    std::vector<float> row;
+
+    while (true) {
+        uint64_t n;
+        int type;
+        int mode;
+        int average;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait(lock, [this]{ return _thread_exit || _input_ready; });
+            if (_thread_exit)
+                break;
+
+            // Only the latest samples are calculated, the skipped ones are out of date
+            input.swap(_input);
+            n = _input_sample_num;
+            type = _input_windows_index;
+            mode = _input_calc_mode;
+            average = _input_average_mode;
+            count = _input_average_count;
+            _input_ready = false;
+
+            if (_average_reset) {
+                _avg_frames = 0;
+                _avg_head = 0;
+                _average_reset = false;
+            }
+        }
+
+        build_plan(n);
+        build_window(n, type);
+        calc_power(input, n, mode);
+        average_power(average, count);
+
+        const uint64_t bins = n/2+1;
+        power_spectrum.resize(bins);
+        row.resize(bins);
+        for (uint64_t k = 0; k < bins; k++) {
+            power_spectrum[k] = sqrt(_avg_power[k]);
+            row[k] = (float)sqrt(_frame_power[k]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            // The length or the averaging may have changed during the calculation
+            if (n != _sample_num || _average_reset)
+                continue;
+            _power_spectrum.swap(power_spectrum);
+            if (!_input_ready)
+                _spectrum_state = Stopped;
+
+            if (_spectrogram_bins != bins) {
+                _spectrogram.assign(bins * SpectrogramDepth, 0);
+                _spectrogram_bins = bins;
+                _spectrogram_head = 0;
+                _spectrogram_rows = 0;
+            }
+            std::copy(row.begin(), row.end(), _spectrogram.begin() + _spectrogram_head * bins);
+            _spectrogram_head = (_spectrogram_head + 1) % SpectrogramDepth;
+            _spectrogram_rows = min(_spectrogram_rows + 1, SpectrogramDepth);
+        }
 
-    // calculate power spectrum
-    _power_spectrum[0] = abs(_xk[0])/wsum;  /* DC component */
-    for (unsigned int k = 1; k < (_sample_num + 1) / 2; ++k)  /* (k < N/2 rounded up) */
-         _power_spectrum[k] = sqrt((_xk[k]*_xk[k] + _xk[_sample_num-k]*_xk[_sample_num-k]) * 2) / wsum;
-    if (_sample_num % 2 == 0) /* N is even */
-         _power_spectrum[_sample_num/2] = abs(_xk[_sample_num/2])/wsum;  /* Nyquist freq. */
+        spectrum_updated();
+    }
+}
+
+void SpectrumStack::calc_power(const std::vector<double> &input, uint64_t n, int mode)
+{
+    const uint64_t bins = n/2+1;
+    const uint64_t hop = (mode == Welch) ? max((uint64_t)1, n/2) : n;
+    const uint64_t segments = (input.size() - n) / hop + 1;
+
+    _frame_power.assign(bins, 0);
+
+    for (uint64_t s = 0; s < segments; s++) {
+        const double *const x = input.data() + s * hop;
+        for (uint64_t i = 0; i < n; i++)
+            _xn[i] = x[i] * _window[i];
+
+        // fft
+        fftw_execute(_fft_plan);
+
+        // accumulate the power spectrum of the segment
+        _frame_power[0] += _xk[0]*_xk[0];  /* DC component */
+        for (uint64_t k = 1; k < (n + 1) / 2; ++k)  /* (k < N/2 rounded up) */
+            _frame_power[k] += (_xk[k]*_xk[k] + _xk[n-k]*_xk[n-k]) * 2;
+        if (n % 2 == 0) /* N is even */
+            _frame_power[n/2] += _xk[n/2]*_xk[n/2];  /* Nyquist freq. */
+    }
+
+    const double scale = 1.0 / (_window_sum * _window_sum * segments);
+    for (uint64_t k = 0; k < bins; k++)
+        _frame_power[k] *= scale;
+}
+
+void SpectrumStack::average_power(int mode, int count)
+{
+    const uint64_t bins = _frame_power.size();
+
+    if (mode == NoAverage || _avg_frames == 0 || _avg_power.size() != bins) {
+        _avg_power = _frame_power;
+        _avg_frames = 0;
+        _avg_head = 0;
+        if (mode == LinearAverage)
+            _avg_history.assign(bins * count, 0);
+    }
+    else if (mode == LinearAverage) {
+        // Moving average, the oldest frame of the ring leaves the sum
+        const int frames = min(_avg_frames, count);
+        const double *old = _avg_history.data() + _avg_head * bins;
+        double sum;
+        for (uint64_t k = 0; k < bins; k++) {
+            sum = _avg_power[k] * frames + _frame_power[k];
+            if (frames == count)
+                sum -= old[k];
+            _avg_power[k] = sum / min(frames + 1, count);
+        }
+    }
+    else if (mode == ExpAverage) {
+        // The first frames are weighted equally so the start is not biased
+        const double alpha = 1.0 / min(_avg_frames + 1, count);
+        for (uint64_t k = 0; k < bins; k++)
+            _avg_power[k] += (_frame_power[k] - _avg_power[k]) * alpha;
+    }
+    else if (mode == PeakHold) {
+        for (uint64_t k = 0; k < bins; k++)
+            _avg_power[k] = max(_avg_power[k], _frame_power[k]);
+    }
+
+    if (mode == LinearAverage) {
+        std::copy(_frame_power.begin(), _frame_power.end(), _avg_history.begin() + _avg_head * bins);
+        _avg_head = (_avg_head + 1) % count;
+    }
+    _avg_frames++;
+}
+
+void SpectrumStack::build_plan(uint64_t n)
+{
+    if (_fft_plan && n == _plan_sample_num)
+        return;
+
+    _xn.resize(n);
+    _xk.resize(n);
+
+    std::lock_guard<std::mutex> lock(g_planner_mutex);
+
+    if (!g_wisdom_loaded) {
+        g_wisdom_loaded = true;
+#ifdef HAVE_FFTW3_THREADS
+        fftw_init_threads();
+#endif
+        if (fftw_import_wisdom_from_filename(fft_wisdom_path().c_str()))
+            dsv_info("Loaded the fft wisdom.");
+    }
+
+    if (_fft_plan)
+        fftw_destroy_plan(_fft_plan);
+
+#ifdef HAVE_FFTW3_THREADS
+    int threads = 1;
+    if (n >= FftThreadsMinSamples)
+        threads = max(1, min((int)std::thread::hardware_concurrency(), FftMaxThreads));
+    fftw_plan_with_nthreads(threads);
+#endif
+
+    // Measuring takes a while the first time a length is used, the wisdom keeps the result
+    _fft_plan = fftw_plan_r2r_1d(n, _xn.data(), _xk.data(),
+                                 FFTW_R2HC, FFTW_MEASURE | FFTW_WISDOM_ONLY);
+    if (_fft_plan == NULL) {
+        _fft_plan = fftw_plan_r2r_1d(n, _xn.data(), _xk.data(),
+                                     FFTW_R2HC, FFTW_MEASURE);
+        g_wisdom_added = true;
+    }
+
+    _plan_sample_num = n;
+}
+
+void SpectrumStack::build_window(uint64_t n, int type)
+{
+    if (n == _window_sample_num && type == _window_type)
+        return;
+
+    _window.resize(n);
+    _window_sum = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        _window[i] = window(i, n, type);
+        _window_sum += _window[i];
+    }
 
-    _spectrum_state = Stopped;
+    _window_sample_num = n;
+    _window_type = type;
 }
 
-double SpectrumStack::window(uint64_t i, int type)
+double SpectrumStack::window(uint64_t i, uint64_t n, int type)
 {
-    const double n_m_1 = _sample_num-1;
+    const double n_m_1 = n-1;
     switch(type) {
     case 1: // Hann window
         return 0.5*(1-cos(2*PI*i/n_m_1));
@@ -25,6 +25,10 @@
 #include "signaldata.h"
 
 #include <list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <boost/optional.hpp> 
   
@@ -56,6 +60,21 @@ public:
         Running
     };
 
+    enum calc_mode {
+        SingleFrame,
+        Welch           // 50% overlapped segments over the whole frame
+    };
+
+    enum average_mode {
+        NoAverage,
+        LinearAverage,  // the last average_count frames
+        ExpAverage,     // weight 1/average_count for the new frame
+        PeakHold
+    };
+
+    // The rows of the spectrogram history
+    static const int SpectrogramDepth;
+
 public:
     SpectrumStack(pv::SigSession *_session, int index);
     virtual ~SpectrumStack();
@@ -76,12 +95,39 @@ public:
     int get_sample_interval();
     void set_sample_interval(int interval);
 
+    int get_calc_mode();
+    void set_calc_mode(int mode);
+
+    int get_average_mode();
+    void set_average_mode(int mode);
+
+    int get_average_count();
+    void set_average_count(int count);
+
+    // Drops the accumulated frames and the spectrogram history
+    void reset_average();
+
     const std::vector<double> get_fft_spectrum();
     double get_fft_spectrum(uint64_t index);
 
+    // The single frame spectrums, oldest row first, bins values per row
+    bool get_spectrogram(std::vector<float> &rows, uint64_t &bins, int &row_count);
+
+    // Hands the current samples to the worker, the result is published by spectrum_updated()
     void calc_fft();
 
-    double window(uint64_t i, int type); 
+    static double window(uint64_t i, uint64_t n, int type);
+
+signals:
+    void spectrum_updated();
+
+private:
+    void fft_proc();
+    void build_plan(uint64_t n);
+    void build_window(uint64_t n, int type);
+    void calc_power(const std::vector<double> &input, uint64_t n, int mode);
+    void average_power(int mode, int count);
+    void reset_average_unlock();
 
 private:
     pv::SigSession *_session;
@@ -92,11 +138,45 @@ private:
     bool _dc_ignore;
     int _sample_interval;
     spectrum_state _spectrum_state;
-
+    int _calc_mode;
+    int _average_mode;
+    int _average_count;
+    bool _average_reset;
+
+    std::condition_variable _cond;
+    std::thread _thread;
+    bool _thread_exit;
+
+    // The last samples handed by calc_fft(), waiting for the worker
+    bool _input_ready;
+    std::vector<double> _input;
+    uint64_t _input_sample_num;
+    int _input_windows_index;
+    int _input_calc_mode;
+    int _input_average_mode;
+    int _input_average_count;
+
+    // Owned by the worker thread
     fftw_plan _fft_plan;
+    uint64_t _plan_sample_num;
     std::vector<double> _xn;
     std::vector<double> _xk;
+    std::vector<double> _window;
+    uint64_t _window_sample_num;
+    int _window_type;
+    double _window_sum;
+    std::vector<double> _frame_power;
+    std::vector<double> _avg_power;
+    std::vector<double> _avg_history;   // ring of the frames of the linear average
+    int _avg_frames;
+    int _avg_head;
+
+    // The published results, guarded by _mutex
     std::vector<double> _power_spectrum;
+    std::vector<float> _spectrogram;
+    uint64_t _spectrogram_bins;
+    int _spectrogram_head;
+    int _spectrogram_rows;
 };
 
 } // namespace data
@@ -104,6 +104,21 @@ void ApplicationParamDlg::bind_font_size_list(QComboBox *box, float size)
     box->setCurrentIndex(selDex);
 }
 
+void ApplicationParamDlg::bind_decode_threads_list(QComboBox *box, int num)
+{
+    box->addItem(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_AUTO), "Auto"), 0);
+
+    for (int i=1; i<=DECODE_WORKER_MAX; i++)
+    {
+        box->addItem(QString::number(i), i);
+    }
+
+    int selDex = box->findData(num);
+    if (selDex == -1)
+        selDex = 0;
+    box->setCurrentIndex(selDex);
+}
+
 bool ApplicationParamDlg::ShowDlg(QWidget *parent)
 {
     DSDialog dlg(parent, true, true);
@@ -132,6 +147,16 @@ bool ApplicationParamDlg::ShowDlg(QWidget *parent)
     QCheckBox *ck_autoScrollLatestData = new QCheckBox();
     ck_autoScrollLatestData->setChecked(app.appOptions.autoScrollLatestData);
 
+    QCheckBox *ck_segmentDecode = new QCheckBox();
+    ck_segmentDecode->setChecked(app.appOptions.segmentDecode);
+
+    QCheckBox *ck_uncompressedSave = new QCheckBox();
+    ck_uncompressedSave->setChecked(app.appOptions.uncompressedSave);
+
+    QComboBox *cbDecodeThreads = new DsComboBox();
+    cbDecodeThreads->setFixedWidth(60);
+    bind_decode_threads_list(cbDecodeThreads, app.appOptions.decodeThreads);
+
     QComboBox *ftCbSize = new DsComboBox();
     ftCbSize->setFixedWidth(50);
     bind_font_size_list(ftCbSize, app.appOptions.fontSize);
@@ -148,6 +173,12 @@ bool ApplicationParamDlg::ShowDlg(QWidget *parent)
     logicLay->addWidget(ck_abortData, 1, 1, Qt::AlignRight);
     logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_AUTO_SCROLL_LATEAST_DATA), "Auto scoll latest")), 2, 0, Qt::AlignLeft); 
     logicLay->addWidget(ck_autoScrollLatestData, 2, 1, Qt::AlignRight);
+    logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_DECODE_THREADS), "Decode threads")), 3, 0, Qt::AlignLeft); 
+    logicLay->addWidget(cbDecodeThreads, 3, 1, Qt::AlignRight);
+    logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_SEGMENT_DECODE), "Segmented decode")), 4, 0, Qt::AlignLeft); 
+    logicLay->addWidget(ck_segmentDecode, 4, 1, Qt::AlignRight);
+    logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_UNCOMPRESSED_SAVE), "Uncompressed save")), 5, 0, Qt::AlignLeft); 
+    logicLay->addWidget(ck_uncompressedSave, 5, 1, Qt::AlignRight);
     lay->addWidget(logicGroup);
 
     //Scope group
@@ -207,6 +238,18 @@ bool ApplicationParamDlg::ShowDlg(QWidget *parent)
             app.appOptions.autoScrollLatestData = ck_autoScrollLatestData->isChecked();
             bAppChanged = true;
         }
+        if (app.appOptions.decodeThreads != cbDecodeThreads->currentData().toInt()){
+            app.appOptions.decodeThreads = cbDecodeThreads->currentData().toInt();
+            bAppChanged = true;
+        }
+        if (app.appOptions.segmentDecode != ck_segmentDecode->isChecked()){
+            app.appOptions.segmentDecode = ck_segmentDecode->isChecked();
+            bAppChanged = true;
+        }
+        if (app.appOptions.uncompressedSave != ck_uncompressedSave->isChecked()){
+            app.appOptions.uncompressedSave = ck_uncompressedSave->isChecked();
+            bAppChanged = true;
+        }
  
         if (bAppChanged){
             app.SaveApp();
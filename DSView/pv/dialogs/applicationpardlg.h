@@ -55,6 +55,8 @@ namespace pv
 
         void bind_font_size_list(QComboBox *box, float size);
 
+        void bind_decode_threads_list(QComboBox *box, int num);
+
     private:
         QStringList _font_name_list; 
     };
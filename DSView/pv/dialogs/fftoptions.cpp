@@ -53,6 +53,10 @@ FftOptions::FftOptions(QWidget *parent, SigSession *session) :
     _dc_checkbox = NULL;
     _view_combobox = NULL;
     _dbv_combobox = NULL;
+    _mode_combobox = NULL;
+    _average_combobox = NULL;
+    _count_combobox = NULL;
+    _spectrogram_checkbox = NULL;
     _hint_label = NULL;
     _glayout = NULL;
     _layout = NULL;
@@ -66,6 +70,10 @@ FftOptions::FftOptions(QWidget *parent, SigSession *session) :
     _dc_checkbox->setChecked(true);
     _view_combobox = new DsComboBox(this);
     _dbv_combobox = new DsComboBox(this);
+    _mode_combobox = new DsComboBox(this);
+    _average_combobox = new DsComboBox(this);
+    _count_combobox = new DsComboBox(this);
+    _spectrogram_checkbox = new QCheckBox(this);
  
     // setup _ch_combobox
     for(auto s : _session->get_signals()) {
@@ -89,6 +97,8 @@ FftOptions::FftOptions(QWidget *parent, SigSession *session) :
     std::vector<uint64_t> length;
     std::vector<QString> view_modes;
     std::vector<int> dbv_ranges;
+    std::vector<QString> calc_modes;
+    std::vector<QString> average_modes;
 
     for(auto t : _session->get_spectrum_traces()) {
         view::SpectrumTrace *spectrumTraces = NULL;
@@ -97,6 +107,8 @@ FftOptions::FftOptions(QWidget *parent, SigSession *session) :
             length = spectrumTraces->get_length_support();
             view_modes = spectrumTraces->get_view_modes_support();
             dbv_ranges = spectrumTraces->get_dbv_ranges();
+            calc_modes = spectrumTraces->get_calc_modes_support();
+            average_modes = spectrumTraces->get_average_modes_support();
             break;
         }
     }
@@ -143,6 +155,23 @@ FftOptions::FftOptions(QWidget *parent, SigSession *session) :
             QVariant::fromValue(dbv_ranges[i]));
     }
 
+    for (unsigned int i = 0; i < calc_modes.size(); i++)
+    {
+        _mode_combobox->addItem(calc_modes[i],
+            QVariant::fromValue(i));
+    }
+    for (unsigned int i = 0; i < average_modes.size(); i++)
+    {
+        _average_combobox->addItem(average_modes[i],
+            QVariant::fromValue(i));
+    }
+    for (int i = 2; i <= 128; i*=2)
+    {
+        _count_combobox->addItem(QString::number(i),
+            QVariant::fromValue(i));
+    }
+    _count_combobox->setCurrentIndex(_count_combobox->findData(16));
+
     // load current settings
     for(auto t : _session->get_spectrum_traces()) {
          view::SpectrumTrace *spectrumTraces = NULL;
@@ -183,6 +212,15 @@ FftOptions::FftOptions(QWidget *parent, SigSession *session) :
                 _window_combobox->setCurrentIndex(spectrumTraces->get_spectrum_stack()->get_windows_index());
                 _dc_checkbox->setChecked(spectrumTraces->get_spectrum_stack()->dc_ignored());
                 _view_combobox->setCurrentIndex(spectrumTraces->view_mode());
+                _mode_combobox->setCurrentIndex(spectrumTraces->get_spectrum_stack()->get_calc_mode());
+                _average_combobox->setCurrentIndex(spectrumTraces->get_spectrum_stack()->get_average_mode());
+                for (int i = 0; i < _count_combobox->count(); i++) {
+                    if (spectrumTraces->get_spectrum_stack()->get_average_count() == _count_combobox->itemData(i).toInt()) {
+                        _count_combobox->setCurrentIndex(i);
+                        break;
+                    }
+                }
+                _spectrogram_checkbox->setChecked(spectrumTraces->spectrogram_enabled());
             }
         }
     }
@@ -211,7 +249,15 @@ FftOptions::FftOptions(QWidget *parent, SigSession *session) :
     _glayout->addWidget(_view_combobox, 6, 1);
     _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_DBV_RANGE), "DBV Range: "), this), 7, 0);
     _glayout->addWidget(_dbv_combobox, 7, 1);
-    _glayout->addWidget(_hint_label, 0, 2, 8, 1);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_FFT_MODE), "FFT Mode: "), this), 8, 0);
+    _glayout->addWidget(_mode_combobox, 8, 1);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_FFT_AVERAGE), "Average: "), this), 9, 0);
+    _glayout->addWidget(_average_combobox, 9, 1);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_FFT_AVERAGE_COUNT), "Average Count: "), this), 10, 0);
+    _glayout->addWidget(_count_combobox, 10, 1);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_FFT_SPECTROGRAM), "Spectrogram: "), this), 11, 0);
+    _glayout->addWidget(_spectrogram_checkbox, 11, 1);
+    _glayout->addWidget(_hint_label, 0, 2, 12, 1);
 
 
     _layout = new QVBoxLayout();
@@ -247,6 +293,10 @@ void FftOptions::accept()
                 spectrumTraces->get_spectrum_stack()->set_sample_num(_len_combobox->currentData().toULongLong());
                 spectrumTraces->get_spectrum_stack()->set_sample_interval(_interval_combobox->currentData().toInt());
                 spectrumTraces->get_spectrum_stack()->set_windows_index(_window_combobox->currentData().toInt());
+                spectrumTraces->get_spectrum_stack()->set_calc_mode(_mode_combobox->currentData().toInt());
+                spectrumTraces->get_spectrum_stack()->set_average_mode(_average_combobox->currentData().toInt());
+                spectrumTraces->get_spectrum_stack()->set_average_count(_count_combobox->currentData().toInt());
+                spectrumTraces->set_spectrogram_enable(_spectrogram_checkbox->isChecked());
                 spectrumTraces->set_view_mode(_view_combobox->currentData().toUInt());
                 
                 spectrumTraces->set_dbv_range(_dbv_combobox->currentData().toInt());
@@ -71,6 +71,10 @@ private:
     QCheckBox *_dc_checkbox;
     DsComboBox *_view_combobox;
     DsComboBox *_dbv_combobox;
+    DsComboBox *_mode_combobox;
+    DsComboBox *_average_combobox;
+    DsComboBox *_count_combobox;
+    QCheckBox *_spectrogram_checkbox;
 
     QLabel *_hint_label;
     QGridLayout *_glayout;
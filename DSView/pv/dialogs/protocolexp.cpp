@@ -232,7 +232,7 @@ void ProtocolExp::save_proc()
     // out.setGenerateByteOrderMark(true); // UTF-8 without BOM
     int row_num = 0;
     ExportRowInfo row_inf_arr[EXPORT_DEC_ROW_COUNT_MAX];
-    std::vector<Annotation*> annotations_arr[EXPORT_DEC_ROW_COUNT_MAX];
+    std::vector<Annotation> annotations_arr[EXPORT_DEC_ROW_COUNT_MAX];
 
     for (std::list<QCheckBox *>::const_iterator i = _row_sel_list.begin();
          i != _row_sel_list.end(); i++)
@@ -314,7 +314,7 @@ void ProtocolExp::save_proc()
             if (row_inf_arr[i].read_index >= annotations_arr[i].size())
                 continue;
             
-            Annotation *ann = annotations_arr[i].at(row_inf_arr[i].read_index);
+            Annotation *ann = &annotations_arr[i].at(row_inf_arr[i].read_index);
             sample_index1 = ann->start_sample();
 
             if (bFirtColumn || sample_index1 < sample_index){
@@ -334,7 +334,7 @@ void ProtocolExp::save_proc()
             if (row_inf_arr[i].read_index >= annotations_arr[i].size())
                 continue;
             
-            Annotation *ann = annotations_arr[i].at(row_inf_arr[i].read_index);           
+            Annotation *ann = &annotations_arr[i].at(row_inf_arr[i].read_index);           
 
             if (ann->start_sample() == sample_index){
                 ann_row_str.append(ann->annotations().at(0));
@@ -356,12 +356,10 @@ void ProtocolExp::save_proc()
     file.close();
 }
 
-bool ProtocolExp::compare_ann_index(const data::decode::Annotation *a, 
-                    const data::decode::Annotation *b)
+bool ProtocolExp::compare_ann_index(const data::decode::Annotation &a, 
+                    const data::decode::Annotation &b)
 {   
-    assert(a);
-    assert(b);
-    return a->start_sample() < b->start_sample();
+    return a.start_sample() < b.start_sample();
 }
 
 } // namespace dialogs
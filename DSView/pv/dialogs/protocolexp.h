@@ -67,8 +67,8 @@ public:
 
 protected:   
     void save_proc();
-    static bool compare_ann_index(const data::decode::Annotation *a, 
-                    const data::decode::Annotation *b);
+    static bool compare_ann_index(const data::decode::Annotation &a, 
+                    const data::decode::Annotation &b);
 
     void closeSelf();
 
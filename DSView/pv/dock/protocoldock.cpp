@@ -448,12 +448,17 @@ void ProtocolDock::del_all_protocol()
 void ProtocolDock::decoded_progress(int progress)
 {
     const auto &decode_sigs = _session->get_decode_signals();
+    auto listed_stack = _session->get_decoder_model()->getDecoderStack();
+    bool bListed = false;
     unsigned int index = 0;
 
     for(auto d : decode_sigs) {
         int pg = d->get_progress();
         QString err;
 
+        if (d->decoder() == listed_stack)
+            bListed = true;
+
         if (d->decoder()->out_of_memory())
             err = L_S(STR_PAGE_DLG, S_ID(IDS_DLG_OUT_OF_MEMORY), "Out of Memory");
 
@@ -471,6 +476,13 @@ void ProtocolDock::decoded_progress(int progress)
         index++;
     }
 
+    // Several decoders may run at the same time, only the one
+    // that is listed in the table refresh the model.
+    auto trace = dynamic_cast<view::DecodeTrace*>(sender());
+    if (trace != NULL && bListed && trace->decoder() != listed_stack){
+        return;
+    }
+
     if (progress == 0 || progress % 10 == 1){
         update_model();
     }  
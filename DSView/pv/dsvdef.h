@@ -56,7 +56,11 @@ enum View_type {
 #define ds_min(a,b) ((a) < (b) ? (a) : (b))
 
 #define SESSION_FORMAT_VERSION      3
-#define HEADER_FORMAT_VERSION       3
+#define HEADER_FORMAT_VERSION       4
+
+// Version 4: a logic block without toggles is an empty entry with this comment,
+// the level and the byte count, see session_driver.c
+#define CONST_BLOCK_COMMENT         "const %d %llu"
 
 namespace DecoderDataFormat
 {
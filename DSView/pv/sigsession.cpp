@@ -47,6 +47,7 @@
 #include <stdexcept>
 #include <sys/stat.h>
 #include <map>
+#include <algorithm>
 #include <QString>
 
 #include "data/decode/decoderstatus.h"
@@ -117,6 +118,7 @@ namespace pv
         _lissajous_trace = NULL;
         _math_trace = NULL;
         _is_decoding = false;
+        _decode_worker_count = 0;
         _bClose = false;
         _callback = NULL;
         _work_time_id = 0;
@@ -855,17 +857,18 @@ namespace pv
 
     void SigSession::check_update()
     {
-        ds_lock_guard lock(_data_mutex);
+        // The view takes the last published dso frame, it does not wait for the
+        // acquisition, which appends the next one to another slot meanwhile.
+        _view_data->get_dso()->acquire_frame();
 
         if (_device_agent.is_collecting() == false)
             return;
 
-        if (_data_updated)
+        if (_data_updated.exchange(false))
         {
             if (_device_agent.get_work_mode() != LOGIC)
                 data_updated();
                 
-            _data_updated = false;
             _noData_cnt = 0;
             data_auto_unlock();
         }
@@ -1333,6 +1336,18 @@ namespace pv
                 m->get_spectrum_stack()->calc_fft();
         }
 
+        // accumulate the whole frames of the persistence display
+        if (!_is_instant)
+        {
+            for (auto s : _signals)
+            {
+                if (s->signal_type() == SR_CHANNEL_DSO && s->enabled()){
+                    view::DsoSignal *dsoSig = (view::DsoSignal*)s;
+                    dsoSig->append_persistence_frame();
+                }
+            }
+        }
+
         // calculate related math results
         if (_math_trace && _math_trace->enabled())
         {
@@ -1681,16 +1696,22 @@ namespace pv
         auto trace = (*it);
         _decode_traces.erase(it);
 
-        bool isRunning = trace->decoder()->IsRunning();
+        bool isRunning = false;
 
         remove_decode_task(trace);
 
-        if (isRunning)
+        if (true)
         {
-            // destroy it in thread
-            trace->_delete_flag = true;
+            std::lock_guard<std::mutex> lock(_decode_task_mutex);
+            isRunning = is_decode_task_running_unlock(trace);
+
+            if (isRunning){
+                // destroy it in thread
+                trace->_delete_flag = true;
+            }
         }
-        else
+
+        if (!isRunning)
         {
             delete trace;
             signals_changed();
@@ -1718,6 +1739,7 @@ namespace pv
         if (have_view_data() && !is_working())
         {
             remove_decode_task(trace); // remove old task
+            wait_decode_task_end(trace); // the worker may still push the results
             trace->decoder()->clear();
             add_decode_task(trace);
             data_updated();
@@ -1889,18 +1911,30 @@ namespace pv
         _session = NULL;
     }
 
-    // append a decode task, and try create a thread
+    // append a decode task, and try create a worker thread
     void SigSession::add_decode_task(view::DecodeTrace *trace)
     {
         std::lock_guard<std::mutex> lock(_decode_task_mutex);
         _decode_tasks.push_back(trace);
 
-        if (!_is_decoding){
-            if (_decode_thread.joinable())
-                _decode_thread.join();
+        // Release the workers those have exited.
+        for (auto id : _decode_end_threads)
+        {
+            for (auto it = _decode_threads.begin(); it != _decode_threads.end(); it++)
+            {
+                if ((*it).get_id() == id){
+                    (*it).join();
+                    _decode_threads.erase(it);
+                    break;
+                }
+            }
+        }
+        _decode_end_threads.clear();
 
-            _decode_thread = std::thread(&SigSession::decode_task_proc, this);
+        if (_decode_worker_count < get_decode_worker_max()){
+            _decode_worker_count++;
             _is_decoding = true;
+            _decode_threads.push_back(std::thread(&SigSession::decode_task_proc, this));
         }
     }
 
@@ -1908,14 +1942,16 @@ namespace pv
     {
         std::lock_guard<std::mutex> lock(_decode_task_mutex);
 
-        for (auto it = _decode_tasks.begin(); it != _decode_tasks.end(); it++)
+        auto it = _decode_tasks.begin();
+
+        while (it != _decode_tasks.end())
         {
-            if ((*it) == trace)
-            {
-                (*it)->decoder()->stop_decode_work();
-                _decode_tasks.erase(it);
+            if ((*it) == trace){
+                it = _decode_tasks.erase(it);
                 dsv_info("remove a waiting decode task");
-                return;
+            }
+            else{
+                it++;
             }
         }
 
@@ -1923,26 +1959,27 @@ namespace pv
         trace->decoder()->stop_decode_work();
     }
 
+    // Returns when no worker runs the task of the trace, stop it first
+    void SigSession::wait_decode_task_end(view::DecodeTrace *trace)
+    {
+        std::unique_lock<std::mutex> lock(_decode_task_mutex);
+
+        _decode_task_cond.wait(lock, [this, trace]{
+            return !is_decode_task_running_unlock(trace);
+        });
+    }
+
     void SigSession::clear_all_decoder(bool bUpdateView)
     {
         if (_decode_traces.empty())
             return;
 
-        // create the wait task deque
-        int dex = -1;
-        clear_all_decode_task(dex);
-
-        view::DecodeTrace *runningTrace = NULL;
-        if (dex != -1)
-        {
-            runningTrace = _decode_traces[dex];
-            runningTrace->_delete_flag = true; // destroy it in thread
-        }
+        // All workers are end after this call.
+        clear_all_decode_task();
 
         for (auto trace : _decode_traces)
         {
-            if (trace != runningTrace)
-                delete trace;
+            delete trace;
         }
         _decode_traces.clear();
 
@@ -1950,8 +1987,10 @@ namespace pv
             signals_changed();
     }
 
-    void SigSession::clear_all_decode_task(int &runningDex)
+    void SigSession::clear_all_decode_task()
     {
+        std::vector<std::thread> threads;
+
         if (true)
         {
             std::lock_guard<std::mutex> lock(_decode_task_mutex);
@@ -1962,24 +2001,25 @@ namespace pv
                 trace->decoder()->stop_decode_work(); // set decode proc stop flag
             }
             _decode_tasks.clear();
-        }
 
-        // make sure the running task can stop
-        runningDex = -1;
-        int dex = 0;
-        for (auto trace : _decode_traces)
-        {
-            if (trace->decoder()->IsRunning())
+            // make sure the running tasks can stop
+            for (auto trace : _decode_running_tasks)
             {
                 trace->decoder()->stop_decode_work();
-                runningDex = dex;
             }
-            dex++;
+
+            threads.swap(_decode_threads);
+        }
+
+        // Wait all workers end, they need the task lock to exit.
+        for (auto &th : threads)
+        {
+            if (th.joinable())
+                th.join();
         }
 
-        // Wait the thread end.
-        if (_decode_thread.joinable())
-            _decode_thread.join();
+        std::lock_guard<std::mutex> lock(_decode_task_mutex);
+        _decode_end_threads.clear();
     }
 
     view::DecodeTrace *SigSession::get_decoder_trace(int index)
@@ -1991,22 +2031,73 @@ namespace pv
         assert(false);
     }
 
+    // Returns NULL when no task can be taken, and the calling worker is retired.
     view::DecodeTrace *SigSession::get_top_decode_task()
     {
         std::lock_guard<std::mutex> lock(_decode_task_mutex);
 
-        auto it = _decode_tasks.begin();
-        if (it != _decode_tasks.end())
+        for (auto it = _decode_tasks.begin(); it != _decode_tasks.end(); it++)
         {
             auto p = (*it);
+
+            // The same decoder is still running by other worker,
+            // it will take this task when that is done.
+            if (is_decode_task_running_unlock(p))
+                continue;
+
             _decode_tasks.erase(it);
+            _decode_running_tasks.push_back(p);
             return p;
         }
 
+        _decode_worker_count--;
+        _decode_end_threads.push_back(std::this_thread::get_id());
+
+        if (_decode_worker_count == 0){
+            _view_data->get_logic()->decode_end();
+            _is_decoding = false;
+        }
+
         return NULL;
     }
 
-    // the decode task thread proc
+    // Returns true if the trace need to be destroyed by the worker.
+    bool SigSession::end_decode_task(view::DecodeTrace *trace)
+    {
+        std::lock_guard<std::mutex> lock(_decode_task_mutex);
+
+        auto it = std::find(_decode_running_tasks.begin(), _decode_running_tasks.end(), trace);
+        if (it != _decode_running_tasks.end())
+            _decode_running_tasks.erase(it);
+
+        _decode_task_cond.notify_all();
+        return trace->_delete_flag;
+    }
+
+    bool SigSession::is_decode_task_running_unlock(view::DecodeTrace *trace)
+    {
+        auto it = std::find(_decode_running_tasks.begin(), _decode_running_tasks.end(), trace);
+        return it != _decode_running_tasks.end();
+    }
+
+    int SigSession::get_decode_worker_max()
+    {
+        // The blocks of a loop capture are released by the decoder,
+        // that is only safe with a single worker.
+        if (is_loop_mode() || !_view_data->get_logic()->is_able_free())
+            return 1;
+
+        int num = AppConfig::Instance().appOptions.decodeThreads;
+
+        if (num <= 0){
+            num = (int)std::thread::hardware_concurrency();
+            num = std::min(num, DECODE_WORKER_MAX);
+        }
+
+        return std::max(std::min(num, DECODE_WORKER_MAX), 1);
+    }
+
+    // the decode worker thread proc, the tasks of different decoders run in parallel
     void SigSession::decode_task_proc()
     {
         dsv_info("------->decode thread start");
@@ -2019,7 +2110,7 @@ namespace pv
                 task->decoder()->begin_decode_work();
             }
 
-            if (task->_delete_flag)
+            if (end_decode_task(task))
             {
                 dsv_info("destroy a decoder in task thread");
 
@@ -2034,10 +2125,7 @@ namespace pv
             task = get_top_decode_task();
         }
 
-        _view_data->get_logic()->decode_end();
-
         dsv_info("------->decode thread end");
-        _is_decoding = false;        
     }
 
     Snapshot *SigSession::get_signal_snapshot()
@@ -2244,6 +2332,9 @@ namespace pv
 
         case DSV_MSG_REV_END_PACKET:
             {
+                // The feed timer stops with the capture, the view takes the last dso frame here
+                _view_data->get_dso()->acquire_frame();
+
                 if (_device_agent.get_work_mode() == LOGIC)
                 {  
                     bool bAddDecoder = false;
@@ -2404,6 +2495,7 @@ namespace pv
         return false;    
     }
 
+    // The callers end the decode workers first, by clear_all_decode_task()
     void SigSession::clear_decode_result()
     {
         for (auto de : _decode_traces){
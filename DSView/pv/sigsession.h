@@ -29,6 +29,8 @@
 #include <stdint.h> 
 #include <QString>
 #include <thread>
+#include <atomic>
+#include <condition_variable>
 #include <QDateTime>
 #include <list>
 
@@ -49,6 +51,9 @@ class DecoderStatus;
 
 typedef std::lock_guard<std::mutex> ds_lock_guard;
 
+// Upper limit of the decode worker threads.
+#define DECODE_WORKER_MAX   8
+
 namespace pv {
 
 namespace data {
@@ -223,6 +228,8 @@ public:
     void rst_decoder(int index); 
     void rst_decoder_by_key_handel(void *handel);
 
+    int get_decode_worker_max();
+
     inline pv::data::DecoderModel* get_decoder_model(){
          return _decoder_model;
     }
@@ -477,15 +484,17 @@ private:
   
     void add_decode_task(view::DecodeTrace *trace);
     void remove_decode_task(view::DecodeTrace *trace);
-    void clear_all_decode_task(int &runningDex);
+    void wait_decode_task_end(view::DecodeTrace *trace);
+    void clear_all_decode_task();
 
     inline void clear_all_decode_task2(){
-        int run_dex = 0;
-        clear_all_decode_task(run_dex);
+        clear_all_decode_task();
     }
    
     void decode_task_proc();
-    view::DecodeTrace* get_top_decode_task();    
+    view::DecodeTrace* get_top_decode_task();
+    bool end_decode_task(view::DecodeTrace *trace);
+    bool is_decode_task_running_unlock(view::DecodeTrace *trace);
 
     void capture_init(); 
     void nodata_timeout();
@@ -556,12 +565,16 @@ private:
     mutable std::mutex      _sampling_mutex;
     mutable std::mutex      _data_mutex;
     mutable std::mutex      _decode_task_mutex;  
-    std::thread             _decode_thread;
+    std::condition_variable _decode_task_cond;   // a running task has ended
+    std::vector<std::thread> _decode_threads;
+    std::vector<std::thread::id> _decode_end_threads;
+    int                     _decode_worker_count;
     volatile bool           _is_decoding;
  
 	std::vector<view::Signal*>      _signals; 
     std::vector<view::DecodeTrace*> _decode_traces;
     std::vector<view::DecodeTrace*> _decode_tasks;
+    std::vector<view::DecodeTrace*> _decode_running_tasks;
     pv::data::DecoderModel          *_decoder_model;
     std::vector<view::SpectrumTrace*> _spectrum_traces;
     view::LissajousTrace            *_lissajous_trace;
@@ -576,7 +589,7 @@ private:
    
     int         _noData_cnt;
     bool        _data_lock;
-    bool        _data_updated;
+    std::atomic<bool> _data_updated;   // set by the acquisition, taken by the view
     int         _data_auto_lock;
 
     QDateTime   _session_time;
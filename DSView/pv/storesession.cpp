@@ -29,6 +29,7 @@
 #include "data/logicsnapshot.h"
 #include "data/dsosnapshot.h"
 #include "data/analogsnapshot.h"
+#include "data/samplekernel.h"
 #include "data/decoderstack.h"
 #include "data/decode/decoder.h"
 #include "data/decode/row.h"
@@ -79,6 +80,7 @@ StoreSession::StoreSession(SigSession *session) :
     _start_index = 0;
     _end_index = 0;
     _is_busy = false;
+    _store_blocks = false;
 }
 
 StoreSession::~StoreSession()
@@ -170,6 +172,9 @@ bool StoreSession::save_start()
     std::string meta_data;
     std::string decoder_data;
     std::string session_data;
+
+    _store_blocks = *type_set.begin() == SR_CHANNEL_LOGIC
+                    && AppConfig::Instance().appOptions.uncompressedSave;
     
     meta_gen(snapshot, meta_data);
     decoders_gen(decoder_data);
@@ -275,6 +280,9 @@ void StoreSession::save_logic(pv::data::LogicSnapshot *logic_snapshot)
         _unit_count = end_index / 8 * to_save_probes;
     }
 
+    // The blocks are compressed on the worker threads, written here in order
+    ZipDeflater deflater(m_zipDoc, _store_blocks);
+
     for(auto s : _session->get_signals()) 
     { 
         int ch_type = s->get_type();
@@ -299,7 +307,7 @@ void StoreSession::save_logic(pv::data::LogicSnapshot *logic_snapshot)
             bool flag = false;
             uint8_t *block_buf = logic_snapshot->get_block_buf(i, ch_index, flag);
             uint64_t block_size = logic_snapshot->get_block_size(i);
-            bool need_malloc = (block_buf == NULL);
+            bool is_const = (block_buf == NULL);
 
             if (i == end_block && end_offset / 8 < block_size && end_offset > 0){
                 block_size = end_offset / 8;
@@ -311,21 +319,34 @@ void StoreSession::save_logic(pv::data::LogicSnapshot *logic_snapshot)
                 }
                 block_size -= start_offset / 8;
             }
-                
-            if (need_malloc) {
-                block_buf = (uint8_t *)malloc(block_size);
-                if (block_buf == NULL) {
-                    _has_error = true;
-                    _error = L_S(STR_PAGE_DLG, S_ID(IDS_MSG_STORESESS_SAVEPROC_ERROR1), 
-                                "Failed to create zip file. Malloc error.");
+            
+            MakeChunkName(chunk_name, i - start_block, ch_index, ch_type, HEADER_FORMAT_VERSION);
+            int ret;
+
+            // The block has no toggles, only its level and size are stored
+            if (is_const) {
+                char comment[64];
+                snprintf(comment, sizeof(comment), CONST_BLOCK_COMMENT,
+                         flag ? 1 : 0, (unsigned long long)block_size);
+                ret = deflater.AddEmpty(chunk_name, comment) ? SR_OK : -1;
+            }
+            else {
+                ret = deflater.Add(chunk_name, (const char*)block_buf, block_size, false) ? SR_OK : -1;
+
+                // The loader installs the mipmap of a whole leaf block instead of scanning it
+                uint64_t mipmap_size = 0;
+                const uint8_t *mipmap = NULL;
+                bool is_cut = (i == start_block && start_offset > 0) 
+                            || (i == end_block && end_offset > 0);
+
+                if (ret == SR_OK && !is_cut){
+                    mipmap = logic_snapshot->get_block_mipmap(i, ch_index, mipmap_size);
                 }
-                else {
-                    memset(block_buf, flag ? 0xff : 0x0, block_size);
+                if (mipmap != NULL){
+                    snprintf(chunk_name, 15, "M-%d/%d", ch_index, i - start_block);
+                    ret = deflater.Add(chunk_name, (const char*)mipmap, mipmap_size, false) ? SR_OK : -1;
                 }
             }
-            
-            MakeChunkName(chunk_name, i - start_block, ch_index, ch_type, HEADER_FORMAT_VERSION);
-            int ret = m_zipDoc.AddFromBuffer(chunk_name, (const char*)block_buf, block_size) ? SR_OK : -1;
 
             if (ret != SR_OK) {
                 if (!_has_error) {
@@ -338,9 +359,6 @@ void StoreSession::save_logic(pv::data::LogicSnapshot *logic_snapshot)
                 if (_has_error){
                     QFile::remove(_file_name);
                 }
-                if (need_malloc){
-                    free(block_buf);
-                }
 
                 return;
             }
@@ -353,13 +371,19 @@ void StoreSession::save_logic(pv::data::LogicSnapshot *logic_snapshot)
                 assert(false);
             }
 
-            if (need_malloc){
-                free(block_buf);
-            }
             progress_updated();
         }        
     }
 
+    if (!_canceled && !deflater.Finish()){
+        _has_error = true;
+        _error = L_S(STR_PAGE_DLG, S_ID(IDS_MSG_STORESESS_SAVEPROC_ERROR2), 
+                    "Failed to create zip file. Please check write permission of this path.");
+        progress_updated();
+        QFile::remove(_file_name);
+        return;
+    }
+
     progress_updated();
 
     if (_canceled || block_count == 0){
@@ -560,6 +584,8 @@ bool StoreSession::meta_gen(data::Snapshot *snapshot, std::string &str)
   
     sprintf(meta, "%s", "[version]\n"); str += meta;
     sprintf(meta, "version = %d\n", HEADER_FORMAT_VERSION); str += meta;
+    // Informational only, the loader reads the method of each zip entry
+    sprintf(meta, "codec = %s\n", _store_blocks ? "stored" : "deflate"); str += meta;
     sprintf(meta, "%s", "[header]\n"); str += meta;
 
     int mode = _session->get_device()->get_work_mode();
@@ -992,7 +1018,8 @@ void StoreSession::export_exec(data::Snapshot *snapshot)
         _unit_count = logic_snapshot->get_ring_sample_count();
         int blk_num = logic_snapshot->get_block_num();       
         std::vector<uint8_t *> buf_vec;
-        std::vector<bool> buf_sample;
+        std::vector<uint8_t> buf_sample;
+        std::vector<const uint8_t *> chunk_vec;
 
         uint64_t start_index = _start_index;
         uint64_t end_index = _end_index;
@@ -1080,20 +1107,28 @@ void StoreSession::export_exec(data::Snapshot *snapshot)
                 return;
             }
 
+            // The channels without toggles have no buffer, a block of them only
+            // repeats the same unit, which is made once.
+            bool constant_block = true;
+            for (auto buf : buf_vec) {
+                if (buf != NULL) {
+                    constant_block = false;
+                    break;
+                }
+            }
+            chunk_vec.resize(buf_vec.size());
+
             for(uint64_t i = 0; !_canceled && i < buf_sample_num; i+=usize){
                 if(buf_sample_num - i < usize){
                     size = buf_sample_num - i;
                 }
 
-                memset(xbuf, 0, size * unitsize);
+                if (!constant_block || i == 0) {
+                    for (unsigned int k = 0; k < buf_vec.size(); k++)
+                        chunk_vec[k] = buf_vec[k] ? buf_vec[k] + i / 8 : NULL;
 
-                for (uint64_t j = 0; j < size; j++) {
-                    for (unsigned int k = 0; k < buf_vec.size(); k++) {
-                        if (buf_vec[k] == NULL && buf_sample[k])
-                            xbuf[j*unitsize+k/8] +=  1 << k%8;
-                        else if (buf_vec[k] && (buf_vec[k][(i+j)/8] & (1 << j%8)))
-                            xbuf[j*unitsize+k/8] +=  1 << k%8;
-                    }
+                    data::transpose_bits(chunk_vec.data(), buf_sample.data(), buf_vec.size(),
+                                         size, unitsize, xbuf);
                 }
 
                 lp.data = xbuf;
@@ -123,6 +123,7 @@ private:
     uint64_t        _start_index;
     uint64_t        _end_index;
     volatile bool   _is_busy;
+    bool            _store_blocks; // the logic blocks are not deflated
 };
 
 } // pv
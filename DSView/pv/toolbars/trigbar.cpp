@@ -30,6 +30,7 @@
 #include "../dialogs/lissajousoptions.h"
 #include "../dialogs/mathoptions.h"
 #include "../view/trace.h"
+#include "../view/dsosignal.h"
 #include "../dialogs/applicationpardlg.h"
 #include "../ui/langresource.h"
 #include "../config/appconfig.h"
@@ -69,6 +70,10 @@ TrigBar::TrigBar(SigSession *session, QWidget *parent) :
 
     _action_lissajous = new QAction(this);
     _action_lissajous->setObjectName(QString::fromUtf8("actionLissajous"));
+
+    _action_persistence = new QAction(this);
+    _action_persistence->setObjectName(QString::fromUtf8("actionPersistence"));
+    _action_persistence->setCheckable(true);
    
     _dark_style = new QAction(this);
     _dark_style->setObjectName(QString::fromUtf8("actionDark"));
@@ -87,6 +92,7 @@ TrigBar::TrigBar(SigSession *session, QWidget *parent) :
     _display_menu->setContentsMargins(0,0,0,0);
     
     _display_menu->addAction(_action_lissajous);    
+    _display_menu->addAction(_action_persistence);
     _display_menu->addMenu(_themes);
 	_display_menu->addAction(_action_dispalyOptions);
 
@@ -117,6 +123,7 @@ TrigBar::TrigBar(SigSession *session, QWidget *parent) :
     connect(_action_fft, SIGNAL(triggered()), this, SLOT(on_actionFft_triggered()));
     connect(_action_math, SIGNAL(triggered()), this, SLOT(on_actionMath_triggered()));
     connect(_action_lissajous, SIGNAL(triggered()), this, SLOT(on_actionLissajous_triggered()));
+    connect(_action_persistence, SIGNAL(triggered()), this, SLOT(on_actionPersistence_triggered()));
     connect(_dark_style, SIGNAL(triggered()), this, SLOT(on_actionDark_triggered()));
     connect(_light_style, SIGNAL(triggered()), this, SLOT(on_actionLight_triggered()));
     connect(_action_dispalyOptions, SIGNAL(triggered()), this, SLOT(on_display_setting()));
@@ -140,6 +147,7 @@ void TrigBar::retranslateUi()
     _setting_button.setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY), "Display"));    
     _themes->setTitle(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY_THEMES), "Themes"));
     _action_lissajous->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY_LISSAJOUS), "Lissajous"));
+    _action_persistence->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY_PERSISTENCE), "Persistence"));
 
    
     _dark_style->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY_THEMES_DARK), "Dark"));
@@ -238,6 +246,7 @@ void TrigBar::reload()
         _search_action->setVisible(true);
         _function_action->setVisible(false);
         _action_lissajous->setVisible(false);
+        _action_persistence->setVisible(false);
         _action_dispalyOptions->setVisible(true);
 
     } else if (mode == ANALOG) {
@@ -247,6 +256,7 @@ void TrigBar::reload()
         _search_action->setVisible(false);
         _function_action->setVisible(false);
         _action_lissajous->setVisible(false);
+        _action_persistence->setVisible(false);
         _action_dispalyOptions->setVisible(true);
 
     } else if (mode == DSO) {
@@ -256,7 +266,11 @@ void TrigBar::reload()
         _search_action->setVisible(false);
         _function_action->setVisible(true);
         _action_lissajous->setVisible(true);
+        _action_persistence->setVisible(true);
         _action_dispalyOptions->setVisible(true);
+
+        // The signals may be new, they take the state of the menu
+        on_actionPersistence_triggered();
     }
 
     DockOptions *opt = getDockOptions();
@@ -311,6 +325,18 @@ void TrigBar::on_actionLissajous_triggered()
     lissajous_dlg.exec();
 }
 
+void TrigBar::on_actionPersistence_triggered()
+{
+    const bool enable = _action_persistence->isChecked();
+
+    for (auto s : _session->get_signals()) {
+        if (s->signal_type() == SR_CHANNEL_DSO) {
+            view::DsoSignal *dsoSig = (view::DsoSignal*)s;
+            dsoSig->set_persistence(enable);
+        }
+    }
+}
+
  void TrigBar::on_display_setting()
  {    
     pv::dialogs::ApplicationParamDlg dlg;
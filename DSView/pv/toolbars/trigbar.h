@@ -73,6 +73,7 @@ private slots:
     void on_actionDark_triggered();
     void on_actionLight_triggered();
     void on_actionLissajous_triggered();
+    void on_actionPersistence_triggered();
     void on_actionFft_triggered();
     void on_actionMath_triggered();
     void on_display_setting();
@@ -109,6 +110,7 @@ private:
     QAction     *_dark_style;
     QAction     *_light_style;
     QAction     *_action_lissajous;
+    QAction     *_action_persistence;
 };
 
 } // namespace toolbars
@@ -46,7 +46,6 @@ const float AnalogSignal::EnvelopeThreshold = 16.0f;
 AnalogSignal::AnalogSignal(data::AnalogSnapshot *data, sr_channel *probe) :
     Signal(probe),
     _data(data),
-    _rects(NULL),
     _hover_en(false),
     _hover_index(0),
     _hover_point(QPointF(-1, -1)),
@@ -86,7 +85,6 @@ AnalogSignal::AnalogSignal(data::AnalogSnapshot *data, sr_channel *probe) :
 AnalogSignal::AnalogSignal(view::AnalogSignal *s, pv::data::AnalogSnapshot *data, sr_channel *probe) :
     Signal(*s, probe),
     _data(data),
-    _rects(NULL),
     _hover_en(false),
     _hover_index(0),
     _hover_point(QPointF(-1, -1)),
@@ -103,10 +101,6 @@ AnalogSignal::AnalogSignal(view::AnalogSignal *s, pv::data::AnalogSnapshot *data
 
 AnalogSignal::~AnalogSignal()
 {
-    if (_rects) {
-        delete[] _rects;
-        _rects = NULL;
-    }
 }
 
 int AnalogSignal::get_hw_offset()
@@ -334,10 +328,7 @@ double AnalogSignal::get_zero_ratio()
  **/
 void AnalogSignal::resize()
 {
-    if (_rects) {
-        delete[] _rects;
-        _rects = NULL;
-    }
+    _trace_cache.clear();
 }
 
 /**
@@ -489,36 +480,41 @@ void AnalogSignal::paint_trace(QPainter &p,
         p.setPen(_colour);
         //p.setPen(QPen(_colour, 2, Qt::SolidLine));
 
-        QPointF *points = new QPointF[sample_count];
-        QPointF *point = points;
         uint64_t yindex = start_index;
 
         const int hw_offset = get_hw_offset();
         float x = start_pixel;
         double  pixels_per_sample = 1.0/samples_per_pixel;
 
-        for (int64_t sample = 0; sample < sample_count; sample++) {
-            uint64_t index = (yindex * channel_num + order) * unit_bytes;
-            float yvalue = samples[index];
+        // The ring moves on each append, so any new data builds the vertices again
+        const std::vector<double> view_key = {0, (double)start_pixel, (double)start_index, (double)sample_count,
+                                              samples_per_pixel, (double)zeroY, _scale, (double)hw_offset,
+                                              top, bottom, (double)order};
 
-            for(uint8_t i = 1; i < unit_bytes; i++){
-                yvalue += (samples[++index] << i*8);
-            }
+        if (_trace_cache.begin_points(view_key, pshot->get_generation(), 0) == 0) {
+            for (int64_t sample = 0; sample < sample_count; sample++) {
+                uint64_t index = (yindex * channel_num + order) * unit_bytes;
+                float yvalue = samples[index];
 
-            yvalue = zeroY + (yvalue - hw_offset) * _scale;
-            yvalue = min(max(yvalue, top), bottom);
-            *point++ = QPointF(x, yvalue);
+                for(uint8_t i = 1; i < unit_bytes; i++){
+                    yvalue += (samples[++index] << i*8);
+                }
 
-            if (yindex == pshot->get_ring_end())
-                break;
+                yvalue = zeroY + (yvalue - hw_offset) * _scale;
+                yvalue = min(max(yvalue, top), bottom);
+                _trace_cache.append_point(x, yvalue);
 
-            yindex++;
-            yindex %= pshot->get_sample_count();
-            x += pixels_per_sample;
+                if (yindex == pshot->get_ring_end())
+                    break;
+
+                yindex++;
+                yindex %= pshot->get_sample_count();
+                x += pixels_per_sample;
+            }
         }
+        _trace_cache.end_points(sample_count);
 
-        p.drawPolyline(points, point - points);
-        delete[] points;
+        p.drawPolyline(_trace_cache.points(), _trace_cache.point_count());
     }
 }
 
@@ -529,6 +525,8 @@ void AnalogSignal::paint_envelope(QPainter &p,
     const double samples_per_pixel, const int order,
     const float top, const float bottom, const int width)
 {
+    (void)width;
+
     using namespace Qt;
     using pv::data::AnalogSnapshot;
     pv::data::AnalogSnapshot *pshot = const_cast<pv::data::AnalogSnapshot*>(snapshot);
@@ -542,60 +540,61 @@ void AnalogSignal::paint_envelope(QPainter &p,
     p.setPen(QPen(NoPen));
     p.setBrush(_colour);
 
-    if (!_rects)
-        _rects = new QRectF[width+10];
-    
-    QRectF *rect = _rects;
-    int px = -1, pre_px;
-    float y_min = zeroY, y_max = zeroY, pre_y_min = zeroY, pre_y_max = zeroY;
-    int pcnt = 0;
-    const double scale_pixels_per_samples = e.scale / samples_per_pixel;
-    int64_t end_v = pshot->get_ring_end();
-    const uint64_t ring_end = max((int64_t)0, end_v / e.scale - 1);
     const int hw_offset = get_hw_offset();
+    const std::vector<double> view_key = {1, (double)start_pixel, (double)start_index, (double)sample_count,
+                                          samples_per_pixel, (double)zeroY, _scale, (double)hw_offset,
+                                          top, bottom, (double)order};
+
+    if (!_trace_cache.begin_rects(view_key, pshot->get_generation())) {
+        int px = -1, pre_px;
+        float y_min = zeroY, y_max = zeroY, pre_y_min = zeroY, pre_y_max = zeroY;
+        const double scale_pixels_per_samples = e.scale / samples_per_pixel;
+        int64_t end_v = pshot->get_ring_end();
+        const uint64_t ring_end = max((int64_t)0, end_v / e.scale - 1);
 
-    float x = start_pixel;
-    for(uint64_t sample = 0; sample < e.length; sample++) {
-        const uint64_t ring_index = (e.start + sample) % (_view->session().cur_samplelimits() / e.scale);
-        if (sample != 0 && ring_index == ring_end)
-            break;
-
-        const AnalogSnapshot::EnvelopeSample *const ev =
-            e.samples + ((e.start + sample) % e.samples_num);
-
-        const float b = min(max((float)(zeroY + (ev->max - hw_offset) * _scale + 0.5), top), bottom);
-        const float t = min(max((float)(zeroY + (ev->min - hw_offset) * _scale + 0.5), top), bottom);
-
-        pre_px = px;
-        if(px != floor(x)) {
-            if (pre_px != -1) {
-                // We overlap this sample with the previous so that vertical
-                // gaps do not appear during steep rising or falling edges
-                if (pre_y_min > y_max)
-                    *rect++ = QRectF(pre_px, y_min, 1.0f, pre_y_min-y_min+1);
-                else if (pre_y_max < y_min)
-                    *rect++ = QRectF(pre_px, pre_y_max, 1.0f, y_max-pre_y_max+1);
-                else
-                    *rect++ = QRectF(pre_px, y_min, 1.0f, y_max-y_min+1);
-                pre_y_min = y_min;
-                pre_y_max = y_max;
-                pcnt++;
-            } else {
-                pre_y_max = min(max(b, top), bottom);
-                pre_y_min = min(max(t, top), bottom);
+        float x = start_pixel;
+        for(uint64_t sample = 0; sample < e.length; sample++) {
+            const uint64_t ring_index = (e.start + sample) % (_view->session().cur_samplelimits() / e.scale);
+            if (sample != 0 && ring_index == ring_end)
+                break;
+
+            const AnalogSnapshot::EnvelopeSample *const ev =
+                e.samples + ((e.start + sample) % e.samples_num);
+
+            const float b = min(max((float)(zeroY + (ev->max - hw_offset) * _scale + 0.5), top), bottom);
+            const float t = min(max((float)(zeroY + (ev->min - hw_offset) * _scale + 0.5), top), bottom);
+
+            pre_px = px;
+            if(px != floor(x)) {
+                if (pre_px != -1) {
+                    // We overlap this sample with the previous so that vertical
+                    // gaps do not appear during steep rising or falling edges
+                    if (pre_y_min > y_max)
+                        _trace_cache.add_rect(QRectF(pre_px, y_min, 1.0f, pre_y_min-y_min+1));
+                    else if (pre_y_max < y_min)
+                        _trace_cache.add_rect(QRectF(pre_px, pre_y_max, 1.0f, y_max-pre_y_max+1));
+                    else
+                        _trace_cache.add_rect(QRectF(pre_px, y_min, 1.0f, y_max-y_min+1));
+                    pre_y_min = y_min;
+                    pre_y_max = y_max;
+                } else {
+                    pre_y_max = min(max(b, top), bottom);
+                    pre_y_min = min(max(t, top), bottom);
+                }
+                px = x;
+                y_max = min(max(b, top), bottom);
+                y_min = min(max(t, top), bottom);
             }
-            px = x;
-            y_max = min(max(b, top), bottom);
-            y_min = min(max(t, top), bottom);
-        }
-        if (px == pre_px) {
-            y_max = max(b, y_max);
-            y_min = min(t, y_min);
+            if (px == pre_px) {
+                y_max = max(b, y_max);
+                y_min = min(t, y_min);
+            }
+            x += scale_pixels_per_samples;
         }
-        x += scale_pixels_per_samples;
+        _trace_cache.end_rects();
     }
 
-    p.drawRects(_rects, pcnt);
+    p.drawRects(_trace_cache.rects(), _trace_cache.rect_count());
 }
 
 void AnalogSignal::paint_hover_measure(QPainter &p, QColor fore, QColor back)
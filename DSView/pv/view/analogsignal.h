@@ -24,6 +24,7 @@
 #define DSVIEW_PV_ANALOGSIGNAL_H
 
 #include "signal.h"
+#include "tracecache.h"
 
 namespace pv {
 
@@ -164,7 +165,7 @@ private:
 private:
 	pv::data::AnalogSnapshot *_data;
 
-    QRectF *_rects;
+    TraceCache _trace_cache;
 
 	float _scale;
     double _zero_vrate;
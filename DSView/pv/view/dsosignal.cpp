@@ -74,6 +74,7 @@ DsoSignal::DsoSignal(data::DsoSnapshot *data,
     _show = true;
     _vDialActive = false;
     _mValid = false;
+    _hw_offset = 0;
     _level_valid = false;
     _autoV = false;
     _autoH = false;
@@ -82,6 +83,9 @@ DsoSignal::DsoSignal(data::DsoSnapshot *data,
     _hover_en = false;
     _hover_index = 0;
     _hover_value = 0;
+    _persist_en = false;
+    _persist_generation = 0;
+    _persist_samples = 0;
 
     GVariant *gvar_list, *gvar_list_vdivs;
 
@@ -169,6 +173,38 @@ void DsoSignal::set_enable(bool enable)
     _en_lock = false;
 }
 
+void DsoSignal::set_persistence(bool enable)
+{
+    if (_persist_en == enable)
+        return;
+
+    _persist_en = enable;
+    _persistence.clear();
+    _persist_image = QImage();
+
+    if (_view) {
+        _view->set_update(_viewport, true);
+        _view->update();
+    }
+}
+
+void DsoSignal::append_persistence_frame()
+{
+    if (!_persist_en || !enabled())
+        return;
+
+    const int index = get_index();
+    if (_data->empty() || !_data->has_data(index))
+        return;
+
+    const uint64_t sample_count = _data->get_sample_count();
+    if (sample_count == 0)
+        return;
+
+    const uint8_t *const samples = _data->get_samples(0, sample_count - 1, index);
+    _persistence.append_frame(samples, sample_count);
+}
+
 void DsoSignal::set_vDialActive(bool active)
 {
     if (enabled())
@@ -190,6 +226,7 @@ bool DsoSignal::go_vDialPre(bool manul)
 
         session->get_device()->set_config_uint64(SR_CONF_PROBE_VDIV,
                               _vDial->get_value(), _probe, NULL);
+        _persistence.clear();
 
         if (session->is_stopped_status()) {
             set_stop_scale(_stop_scale * (pre_vdiv/_vDial->get_value()));
@@ -225,6 +262,7 @@ bool DsoSignal::go_vDialNext(bool manul)
 
         session->get_device()->set_config_uint64(SR_CONF_PROBE_VDIV,
                               _vDial->get_value(), _probe, NULL);
+        _persistence.clear();
 
         if (session->is_stopped_status()) {
             set_stop_scale(_stop_scale * (pre_vdiv/_vDial->get_value()));
@@ -375,6 +413,7 @@ void DsoSignal::set_acCoupling(uint8_t coupling)
         _acCoupling = coupling; 
         session->get_device()->set_config_byte(SR_CONF_PROBE_COUPLING,
                               _acCoupling, _probe, NULL);
+        _persistence.clear();
     }
 }
 
@@ -469,6 +508,8 @@ void DsoSignal::set_zero_ratio(double ratio)
     _zero_offset = ratio2value(ratio); 
     session->get_device()->set_config_uint16(SR_CONF_PROBE_OFFSET,
                           _zero_offset, _probe, NULL);
+    // The raw values of the old frames are off now
+    _persistence.clear();
 }
 
 void DsoSignal::set_factor(uint64_t factor)
@@ -517,7 +558,8 @@ QString DsoSignal::get_measure(enum DSO_MEASURE_TYPE type)
     }
 
     if (_mValid) {
-        const int hw_offset = get_hw_offset();
+        // Taken by paint_mid() with the measure, not queried for every item
+        const int hw_offset = _hw_offset;
 
         switch(type) {
         case DSO_MS_AMPT:
@@ -804,6 +846,9 @@ void DsoSignal::paint_mid(QPainter &p, int left, int right, QColor fore, QColor
             (int64_t)0), last_sample);
         const int hw_offset = get_hw_offset();
 
+        if (_persist_en)
+            paint_persistence(p, zeroY, left, hw_offset, pixels_offset, samples_per_pixel);
+
         if (samples_per_pixel < EnvelopeThreshold) {
             _data->enable_envelope(false);
             paint_trace(p, _data, zeroY, left,
@@ -817,9 +862,12 @@ void DsoSignal::paint_mid(QPainter &p, int left, int right, QColor fore, QColor
         }
 
         sr_status status;
+        data::SampleStats stats;
+        uint64_t sample_count = 0;
         
         if (session->dso_status_is_valid()) {
             _mValid = true;
+            _hw_offset = hw_offset;
             status = session->get_dso_status();
 
             if (status.measure_valid) {
@@ -865,6 +913,22 @@ void DsoSignal::paint_mid(QPainter &p, int left, int right, QColor fore, QColor
                 _mean = hw_offset - _mean / _data->get_sample_count();
             }
         }
+        else if (_data->get_sample_stats(index, stats, sample_count)) {
+            // No measure from the device, take the range, rms and mean of the frame.
+            // The levels and the cycles are only counted by the hardware.
+            _mValid = true;
+            _hw_offset = hw_offset;
+            _level_valid = false;
+            _period = 0;
+            _pcount = 0;
+            _min = stats.min;
+            _max = stats.max;
+
+            const double mean = (double)stats.sum / sample_count;
+            const double square = (double)stats.square_sum / sample_count;
+            _rms = sqrt(max(hw_offset * (hw_offset - 2 * mean) + square, 0.0));
+            _mean = hw_offset - mean;
+        }
     }
 }
 
@@ -982,35 +1046,38 @@ void DsoSignal::paint_trace(QPainter &p,
         trace_colour.setAlpha(View::ForeAlpha);
         p.setPen(trace_colour);
 
-        QPointF *points = new QPointF[sample_count];
-        QPointF *point = points;
-
         float top = get_view_rect().top();
         float bottom = get_view_rect().bottom();
         float right =  (float)get_view_rect().right();
         double  pixels_per_sample = 1.0/samples_per_pixel;
+        const double x0 = (start / samples_per_pixel - pixels_offset) + left + _view->trig_hoff()*pixels_per_sample;
+
+        // The end is not a part of the key, the new samples of an instant frame are appended
+        const std::vector<double> view_key = {0, (double)start, x0, pixels_per_sample,
+                                              (double)zeroY, _scale, (double)hw_offset, top, bottom, right};
+        int64_t sample = _trace_cache.begin_points(view_key, pshot->get_frame_index(), start);
 
         uint8_t value; 
-        float x = (start / samples_per_pixel - pixels_offset) + left + _view->trig_hoff()*pixels_per_sample;
+        float x;
         float y;
+        QPointF last;
  
-        for (int64_t sample = 0; sample < sample_count; sample++) {
-            value = samples_buffer[sample];
+        for (; sample <= end; sample++) {
+            value = samples_buffer[sample - start];
+            x = x0 + (sample - start) * pixels_per_sample;
             y = min(max(top, zeroY + (value - hw_offset) * _scale), bottom);
             if (x > right) {
-                point--;
-                const float lastY = point->y() + (y - point->y()) / (x - point->x()) * (right - point->x());
-                point++;
-                *point++ = QPointF(right, lastY);
+                if (_trace_cache.last_point(last)) {
+                    const float lastY = last.y() + (y - last.y()) / (x - last.x()) * (right - last.x());
+                    _trace_cache.close_points(right, lastY);
+                }
                 break;
             }
-            *point++ = QPointF(x, y);
-            x += pixels_per_sample;
+            _trace_cache.append_point(x, y);
         }
+        _trace_cache.end_points(sample);
 
-        p.drawPolyline(points, point - points);
-
-        delete[] points;
+        p.drawPolyline(_trace_cache.points(), _trace_cache.point_count());
     }
 }
 
@@ -1037,34 +1104,80 @@ void DsoSignal::paint_envelope(QPainter &p,
     envelope_colour.setAlpha(View::ForeAlpha);
     p.setBrush(envelope_colour);
 
-	QRectF *const rects = new QRectF[e.length];
-	QRectF *rect = rects;
     float top = get_view_rect().top();
     float bottom = get_view_rect().bottom();
-    for(uint64_t sample = 0; sample < e.length-1; sample++) {
-		const float x = ((e.scale * sample + e.start) /
-            samples_per_pixel - pixels_offset) + left + _view->trig_hoff()/samples_per_pixel;
-        const DsoSnapshot::EnvelopeSample *const s =
-			e.samples + sample;
-
-		// We overlap this sample with the next so that vertical
-		// gaps do not appear during steep rising or falling edges
-        const float b = min(max(top, ((max(s->max, (s+1)->min) - hw_offset) * _scale + zeroY)), bottom);
-        const float t = min(max(top, ((min(s->min, (s+1)->max) - hw_offset) * _scale + zeroY)), bottom);
-
-		float h = b - t;
-		if(h >= 0.0f && h <= 1.0f)
-			h = 1.0f;
-		if(h <= 0.0f && h >= -1.0f)
-			h = -1.0f;
-
-		*rect++ = QRectF(x, t, 1.0f, h);
-	}
-
-	p.drawRects(rects, e.length);
-
-	delete[] rects;
-    //delete[] e.samples;
+    const double x0 = (e.start / samples_per_pixel - pixels_offset) + left + _view->trig_hoff()/samples_per_pixel;
+    const double pixels_per_sample = e.scale / samples_per_pixel;
+    const std::vector<double> view_key = {1, (double)e.start, (double)e.length, x0, pixels_per_sample,
+                                          (double)zeroY, _scale, (double)hw_offset, top, bottom};
+
+    if (!_trace_cache.begin_rects(view_key, pshot->get_frame_index())) {
+        for(uint64_t sample = 0; sample < e.length-1; sample++) {
+            const float x = x0 + sample * pixels_per_sample;
+            const DsoSnapshot::EnvelopeSample *const s =
+                e.samples + sample;
+
+            // We overlap this sample with the next so that vertical
+            // gaps do not appear during steep rising or falling edges
+            const float b = min(max(top, ((max(s->max, (s+1)->min) - hw_offset) * _scale + zeroY)), bottom);
+            const float t = min(max(top, ((min(s->min, (s+1)->max) - hw_offset) * _scale + zeroY)), bottom);
+
+            // The samples of a pixel column make one rectangle
+            _trace_cache.append_span(x, t, b);
+        }
+        _trace_cache.end_rects();
+    }
+
+	p.drawRects(_trace_cache.rects(), _trace_cache.rect_count());
+}
+
+void DsoSignal::paint_persistence(QPainter &p, int zeroY, int left, int hw_offset,
+    const double pixels_offset, const double samples_per_pixel)
+{
+    using pv::data::DsoPersistence;
+
+    // The image is made again only when the worker has folded a new frame
+    const uint64_t generation = _persistence.get_generation();
+
+    if (generation != _persist_generation || _persist_image.isNull()) {
+        int columns;
+        float norm;
+        float max_hits;
+
+        _persist_generation = generation;
+        if (!_persistence.get_histogram(_persist_hits, columns, _persist_samples, norm, max_hits)) {
+            _persist_image = QImage();
+            return;
+        }
+
+        // Log scale, the rare hits stay visible beside the repeated ones
+        const float k = 255.0f / log1pf(max_hits / norm);
+        const QRgb rgb = _colour.rgb();
+
+        _persist_image = QImage(columns, DsoPersistence::Levels, QImage::Format_ARGB32);
+        for (int v = 0; v < DsoPersistence::Levels; v++) {
+            QRgb *const line = (QRgb*)_persist_image.scanLine(v);
+            const float *hits = _persist_hits.data() + v;
+
+            for (int col = 0; col < columns; col++, hits += DsoPersistence::Levels) {
+                const int alpha = min((int)(log1pf(*hits / norm) * k), 255);
+                line[col] = qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), alpha);
+            }
+        }
+    }
+
+    if (_persist_image.isNull())
+        return;
+
+    // The rows are the raw values, laid out like the samples of the trace
+    const double x0 = left - pixels_offset + _view->trig_hoff()/samples_per_pixel;
+    const QRectF target(x0, zeroY + (-hw_offset - 0.5) * _scale,
+                        _persist_samples / samples_per_pixel, DsoPersistence::Levels * _scale);
+
+    p.save();
+    p.setClipRect(get_view_rect());
+    p.drawImage(target, _persist_image);
+    p.restore();
 }
 
 void DsoSignal::paint_type_options(QPainter &p, int right, const QPoint pt, QColor fore)
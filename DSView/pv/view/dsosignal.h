@@ -23,8 +23,12 @@
 #ifndef DSVIEW_PV_DSOSIGNAL_H
 #define DSVIEW_PV_DSOSIGNAL_H
 
+#include <QImage>
 #include "signal.h"
 #include "../dstimer.h"
+#include "../data/dsopersistence.h"
+#include "tracecache.h"
+#include <atomic>
   
 namespace pv {
 namespace data {
@@ -117,6 +121,20 @@ public:
 
     void set_enable(bool enable);
 
+    /**
+     * Persistence display, the older frames fade out behind the last one.
+     **/
+    void set_persistence(bool enable);
+
+    inline bool persistence_enabled(){
+        return _persist_en;
+    }
+
+    /**
+     * Hands the whole frame of the snapshot to the persistence histogram
+     **/
+    void append_persistence_frame();
+
     inline bool get_vDialActive(){
         return _vDialActive;
     }
@@ -259,6 +277,9 @@ private:
         const double pixels_offset, const double samples_per_pixel,
         uint64_t num_channels);
 
+    void paint_persistence(QPainter &p, int zeroY, int left, int hw_offset,
+        const double pixels_offset, const double samples_per_pixel);
+
     void paint_hover_measure(QPainter &p, QColor fore, QColor back);
     void auto_set();
 
@@ -283,6 +304,7 @@ private:
     int _zero_offset;
 
     bool _mValid;
+    int _hw_offset;
     uint8_t _max;
     uint8_t _min;
     double _period;
@@ -307,6 +329,14 @@ private:
     QPointF _hover_point;
     float _hover_value;
     DsTimer _end_timer;
+    TraceCache _trace_cache;
+
+    std::atomic<bool> _persist_en; // set by the view, read by the feed thread
+    data::DsoPersistence _persistence;
+    QImage _persist_image;
+    uint64_t _persist_generation;
+    uint64_t _persist_samples;
+    std::vector<float> _persist_hits;
 };
 
 } // namespace view
@@ -281,7 +281,7 @@ void MathTrace::paint_trace(QPainter &p,
         if ((uint64_t)end >= _math_stack->get_sample_num())
             return;
 
-        const double *const values = _math_stack->get_math(start);
+        const data::MathStack::MathValue *const values = _math_stack->get_math(start);
         assert(values);
 
         QPointF *points = new QPointF[sample_count];
@@ -293,7 +293,7 @@ void MathTrace::paint_trace(QPainter &p,
         double  pixels_per_sample = 1.0/samples_per_pixel;
 
         for (int64_t index = 0; index < sample_count; index++) {
-            const float y = min(max(top, zeroY - (values[index] * _scale)), bottom);
+            const float y = min(max(top, zeroY - ((double)values[index] * _scale)), bottom);
             if (x > get_view_rect().right()) {
                 point--;
                 const float lastY = point->y() + (y - point->y()) / (x - point->x()) * (get_view_rect().right() - point->x());
@@ -340,8 +340,8 @@ void MathTrace::paint_envelope(QPainter &p,
 
 		// We overlap this sample with the next so that vertical
 		// gaps do not appear during steep rising or falling edges
-        const float b = min(max(top, zeroY - max(s->max, (s+1)->min) * _scale), bottom);
-        const float t = min(max(top, zeroY - min(s->min, (s+1)->max) * _scale), bottom);
+        const float b = min(max(top, zeroY - (double)max(s->max, (s+1)->min) * _scale), bottom);
+        const float t = min(max(top, zeroY - (double)min(s->min, (s+1)->max) * _scale), bottom);
 
 		float h = b - t;
 		if(h >= 0.0f && h <= 1.0f)
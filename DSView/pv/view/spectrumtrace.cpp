@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <math.h>
 #include <QTextStream>
+#include <QImage>
 #include <boost/functional/hash.hpp>
 #include <stdlib.h>
 
@@ -45,6 +46,8 @@ namespace
 {
     QString FFT_ViewMode[2];
     QString windows_support[5];
+    QString calc_modes_support[2];
+    QString average_modes_support[4];
 
     static const uint64_t length_support[5] = {
         1024,
@@ -85,6 +88,7 @@ SpectrumTrace::SpectrumTrace(pv::SigSession *session,
     _session(session), 
     _enable(false),
     _view_mode(0),
+    _spectrogram_en(false),
     _hover_en(false),
     _scale(1),
     _offset(0)
@@ -99,6 +103,8 @@ SpectrumTrace::SpectrumTrace(pv::SigSession *session,
   
     _spectrum_stack = spectrum_stack;
 
+    connect(_spectrum_stack, SIGNAL(spectrum_updated()), this, SLOT(on_spectrum_updated()));
+
     update_lang_text();
 }
 
@@ -137,6 +143,22 @@ std::vector<QString> SpectrumTrace::get_view_modes_support()
     return modes;
 }
 
+bool SpectrumTrace::spectrogram_enabled()
+{
+    return _spectrogram_en;
+}
+
+void SpectrumTrace::set_spectrogram_enable(bool enable)
+{
+    _spectrogram_en = enable;
+}
+
+void SpectrumTrace::on_spectrum_updated()
+{
+    if (_view && enabled())
+        _view->update();
+}
+
 pv::data::SpectrumStack* SpectrumTrace::get_spectrum_stack()
 {
     return _spectrum_stack;
@@ -338,6 +360,10 @@ void SpectrumTrace::paint_mid(QPainter &p, int left, int right, QColor fore, QCo
 
         const double scale = height / (_vmax - _vmin);
 
+        if (_spectrogram_en)
+            paint_spectrogram(p, left, right, view_off, pixels_per_sample,
+                              20*log10((vdiv*DS_CONF_DSO_HDIVS*vfactor)*VerticalRate));
+
         double x = (view_start-view_off)*pixels_per_sample;
         uint64_t sample = view_start;
         if (dc_ignored && sample == 0) {
@@ -364,6 +390,60 @@ void SpectrumTrace::paint_mid(QPainter &p, int left, int right, QColor fore, QCo
     }
 }
 
+void SpectrumTrace::paint_spectrogram(QPainter &p, int left, int right, double view_off,
+                                      double pixels_per_sample, double db_max)
+{
+    std::vector<float> rows;
+    uint64_t bins;
+    int row_count;
+    if (!_spectrum_stack->get_spectrogram(rows, bins, row_count))
+        return;
+
+    const int width = right - left;
+    if (width <= 0)
+        return;
+
+    const double db_min = db_max - _dbv_range;
+    const uint64_t first_bin = _spectrum_stack->dc_ignored() ? 1 : 0;
+
+    // One image line per frame, the newest on the top
+    QImage image(width, row_count, QImage::Format_RGB32);
+    for (int r = 0; r < row_count; r++) {
+        const float *const row = rows.data() + r * bins;
+        QRgb *const line = (QRgb*)image.scanLine(row_count - 1 - r);
+
+        for (int x = 0; x < width; x++) {
+            // The bins of a pixel column show the largest one
+            uint64_t b0 = max(first_bin, (uint64_t)floor(view_off + x / pixels_per_sample));
+            uint64_t b1 = max(b0 + 1, (uint64_t)floor(view_off + (x + 1) / pixels_per_sample));
+            b1 = min(b1, bins);
+
+            float mag = 0;
+            for (uint64_t b = b0; b < b1; b++)
+                mag = max(mag, row[b]);
+
+            const double db = (mag > 0) ? 20*log10(mag) : db_min;
+            const double level = min(max((db - db_min) / (db_max - db_min), 0.0), 1.0);
+
+            // black, blue, red, yellow, white
+            const double c = level * 4;
+            int red, green, blue;
+            if (c < 1) {
+                red = 0; green = 0; blue = 255 * c;
+            } else if (c < 2) {
+                red = 255 * (c - 1); green = 0; blue = 255 * (2 - c);
+            } else if (c < 3) {
+                red = 255; green = 255 * (c - 2); blue = 0;
+            } else {
+                red = 255; green = 255; blue = 255 * (c - 3);
+            }
+            line[x] = qRgb(red, green, blue);
+        }
+    }
+
+    p.drawImage(QRect(left, UpMargin, width, get_view_rect().height()), image);
+}
+
 void SpectrumTrace::paint_fore(QPainter &p, int left, int right, QColor fore, QColor back)
 {
     using namespace Qt;
@@ -520,6 +600,26 @@ const std::vector<QString> SpectrumTrace::get_windows_support()
     return list;
 }
 
+const std::vector<QString> SpectrumTrace::get_calc_modes_support()
+{
+    std::vector<QString> list;
+    for (size_t i = 0; i < sizeof(calc_modes_support)/sizeof(calc_modes_support[0]); i++)
+    {
+        list.push_back(calc_modes_support[i]);
+    }
+    return list;
+}
+
+const std::vector<QString> SpectrumTrace::get_average_modes_support()
+{
+    std::vector<QString> list;
+    for (size_t i = 0; i < sizeof(average_modes_support)/sizeof(average_modes_support[0]); i++)
+    {
+        list.push_back(average_modes_support[i]);
+    }
+    return list;
+}
+
 const std::vector<uint64_t> SpectrumTrace::get_length_support()
 {
     std::vector<uint64_t> list;
@@ -540,6 +640,14 @@ void SpectrumTrace::update_lang_text()
 
     FFT_ViewMode[0] = L_S(STR_PAGE_DLG, S_ID(IDS_FFT_MODE_LINEARRSM), "Linear RMS");
     FFT_ViewMode[1] = "DBV RMS";
+
+    calc_modes_support[0] = L_S(STR_PAGE_DLG, S_ID(IDS_FFT_CALC_SINGLE), "Single Frame");
+    calc_modes_support[1] = L_S(STR_PAGE_DLG, S_ID(IDS_FFT_CALC_WELCH), "Welch");
+
+    average_modes_support[0] = L_S(STR_PAGE_DLG, S_ID(IDS_FFT_AVERAGE_NONE), "None");
+    average_modes_support[1] = L_S(STR_PAGE_DLG, S_ID(IDS_FFT_AVERAGE_LINEAR), "Linear");
+    average_modes_support[2] = L_S(STR_PAGE_DLG, S_ID(IDS_FFT_AVERAGE_EXP), "Exponential");
+    average_modes_support[3] = L_S(STR_PAGE_DLG, S_ID(IDS_FFT_AVERAGE_PEAK), "Peak Hold");
 }
 
 } // namespace view
@@ -91,6 +91,9 @@ public:
     void set_view_mode(unsigned int mode);
     std::vector<QString> get_view_modes_support();
 
+    bool spectrogram_enabled();
+    void set_spectrogram_enable(bool enable);
+
     pv::data::SpectrumStack* get_spectrum_stack();
 
     static QString format_freq(double freq, unsigned precision = Pricision);
@@ -126,13 +129,20 @@ public:
     void update_lang_text();
     const std::vector<QString> get_windows_support();
     const std::vector<uint64_t> get_length_support();
+    const std::vector<QString> get_calc_modes_support();
+    const std::vector<QString> get_average_modes_support();
 
 protected:
     void paint_type_options(QPainter &p, int right, const QPoint pt, QColor fore);
 
+private:
+    void paint_spectrogram(QPainter &p, int left, int right, double view_off,
+                           double pixels_per_sample, double db_max);
+
 private:
 
 private slots:
+    void on_spectrum_updated();
 
 private:
     pv::SigSession *_session;
@@ -140,6 +150,7 @@ private:
 
     bool _enable;
     int _view_mode;
+    bool _spectrogram_en;
 
     double _vmax;
     double _vmin;
@@ -0,0 +1,209 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2022 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "tracecache.h"
+#include <math.h>
+#include <algorithm>
+
+using namespace std;
+
+namespace pv {
+namespace view {
+
+TraceCache::TraceCache()
+{
+    clear();
+}
+
+void TraceCache::clear()
+{
+    _view_key.clear();
+    _frame = 0;
+    _valid = false;
+    _points.clear();
+    _open_size = 0;
+    _next = 0;
+    _closed = false;
+    _col_open = false;
+    _col = 0;
+    _rects.clear();
+    _span_open = false;
+    _span_col = 0;
+    _span_top = 0;
+    _span_bottom = 0;
+}
+
+int64_t TraceCache::begin_points(const std::vector<double> &view_key, uint64_t frame, int64_t start)
+{
+    if (_valid && frame == _frame && _next >= start && view_key == _view_key) {
+        // Drop the vertices of the open column, it goes on with the new samples
+        _points.resize(_open_size);
+        return _closed ? INT64_MAX : _next;
+    }
+
+    _view_key = view_key;
+    _frame = frame;
+    _valid = true;
+    _points.clear();
+    _open_size = 0;
+    _next = start;
+    _closed = false;
+    _col_open = false;
+    _rects.clear();
+
+    return start;
+}
+
+void TraceCache::append_point(float x, float y)
+{
+    const QPointF pt(x, y);
+    const int col = (int)floor(x);
+
+    if (_col_open && col == _col) {
+        if (y < _low.y())
+            _low = pt;
+        if (y > _high.y())
+            _high = pt;
+        _last = pt;
+        return;
+    }
+
+    flush_column();
+
+    _col_open = true;
+    _col = col;
+    _first = pt;
+    _low = pt;
+    _high = pt;
+    _last = pt;
+}
+
+bool TraceCache::last_point(QPointF &pt)
+{
+    if (_col_open) {
+        pt = _last;
+        return true;
+    }
+    if (!_points.empty()) {
+        pt = _points.back();
+        return true;
+    }
+    return false;
+}
+
+void TraceCache::close_points(float x, float y)
+{
+    append_point(x, y);
+    _closed = true;
+}
+
+void TraceCache::end_points(int64_t next)
+{
+    if (!_closed)
+        _next = next;
+
+    // The open column is kept to take the samples of the next update
+    _open_size = _points.size();
+
+    if (_col_open) {
+        flush_column();
+        _col_open = true;
+    }
+}
+
+void TraceCache::flush_column()
+{
+    if (!_col_open)
+        return;
+
+    // The extremes in the order of the samples
+    const QPointF &a = (_high.x() < _low.x()) ? _high : _low;
+    const QPointF &b = (_high.x() < _low.x()) ? _low : _high;
+
+    _points.push_back(_first);
+    if (a != _first && a != _last)
+        _points.push_back(a);
+    if (b != _first && b != _last && b != a)
+        _points.push_back(b);
+    if (_last != _first)
+        _points.push_back(_last);
+
+    _col_open = false;
+}
+
+bool TraceCache::begin_rects(const std::vector<double> &view_key, uint64_t frame)
+{
+    if (_valid && frame == _frame && view_key == _view_key)
+        return true;
+
+    _view_key = view_key;
+    _frame = frame;
+    _valid = true;
+    _rects.clear();
+    _span_open = false;
+    _points.clear();
+    _open_size = 0;
+    _col_open = false;
+
+    return false;
+}
+
+void TraceCache::append_span(float x, float top, float bottom)
+{
+    const int col = (int)floor(x);
+    const float t = min(top, bottom);
+    const float b = max(top, bottom);
+
+    if (_span_open && col == _span_col) {
+        _span_top = min(_span_top, t);
+        _span_bottom = max(_span_bottom, b);
+        return;
+    }
+
+    flush_span();
+
+    _span_open = true;
+    _span_col = col;
+    _span_top = t;
+    _span_bottom = b;
+}
+
+void TraceCache::add_rect(const QRectF &rect)
+{
+    _rects.push_back(rect);
+}
+
+void TraceCache::end_rects()
+{
+    flush_span();
+}
+
+void TraceCache::flush_span()
+{
+    if (!_span_open)
+        return;
+
+    _rects.push_back(QRectF(_span_col, _span_top, 1.0f, max(_span_bottom - _span_top, 1.0f)));
+    _span_open = false;
+}
+
+} // namespace view
+} // namespace pv
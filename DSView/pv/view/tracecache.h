@@ -0,0 +1,113 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2022 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef DSVIEW_PV_VIEW_TRACECACHE_H
+#define DSVIEW_PV_VIEW_TRACECACHE_H
+
+#include <QPointF>
+#include <QRectF>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pv {
+namespace view {
+
+//The vertices of a trace, kept between the repaints.
+//A pixel column gets its first, lowest, highest and last vertex only,
+//so the painter works on the width of the view, not on the sample count.
+class TraceCache
+{
+public:
+    TraceCache();
+
+    void clear();
+
+    /*
+     * Polyline of the samples.
+     * begin_points() returns the first sample index to append: start if the
+     * vertices are built again, the sample after the cached ones if only
+     * newer samples of the same frame are missing.
+     */
+    int64_t begin_points(const std::vector<double> &view_key, uint64_t frame, int64_t start);
+    void append_point(float x, float y);
+    bool last_point(QPointF &pt);
+    // The trace leaves the view, no sample is appended after this vertex
+    void close_points(float x, float y);
+    void end_points(int64_t next);
+
+    inline const QPointF* points(){
+        return _points.data();
+    }
+
+    inline int point_count(){
+        return (int)_points.size();
+    }
+
+    /*
+     * One rectangle per pixel column.
+     * begin_rects() returns true when the cached rectangles are up to date.
+     */
+    bool begin_rects(const std::vector<double> &view_key, uint64_t frame);
+    void append_span(float x, float top, float bottom);
+    void add_rect(const QRectF &rect);
+    void end_rects();
+
+    inline const QRectF* rects(){
+        return _rects.data();
+    }
+
+    inline int rect_count(){
+        return (int)_rects.size();
+    }
+
+private:
+    void flush_column();
+    void flush_span();
+
+private:
+    std::vector<double> _view_key;
+    uint64_t    _frame;
+    bool        _valid;
+
+    std::vector<QPointF> _points;
+    size_t      _open_size;   // the vertices before the open column
+    int64_t     _next;        // the sample after the appended ones
+    bool        _closed;
+
+    bool        _col_open;
+    int         _col;
+    QPointF     _first;
+    QPointF     _low;
+    QPointF     _high;
+    QPointF     _last;
+
+    std::vector<QRectF> _rects;
+    bool        _span_open;
+    int         _span_col;
+    float       _span_top;
+    float       _span_bottom;
+};
+
+} // namespace view
+} // namespace pv
+
+#endif // DSVIEW_PV_VIEW_TRACECACHE_H
@@ -90,6 +90,11 @@ Viewport::Viewport(View &parent, View_type type) :
     _edge_hit = false;
     _transfer_started = false;
     _timer_cnt = 0;
+    _frame_paints = 0;
+    _frame_paint_sum = 0;
+    _frame_paint_max = 0;
+    _frame_published = 0;
+    _frame_dropped = 0;
   
     _sample_received = 0;
     _is_checked_trig = false;
@@ -159,6 +164,9 @@ void Viewport::paintEvent(QPaintEvent *event)
 void Viewport::doPaint()
 {     
     using pv::view::Signal;
+
+    QElapsedTimer paint_time;
+    paint_time.start();
    
     QStyleOption o;
     o.initFrom(this);
@@ -241,6 +249,58 @@ void Viewport::doPaint()
             _curSignalHeight = _view.get_signalHeight();
 
 	p.end();
+
+    update_frame_time(paint_time.nsecsElapsed());
+}
+
+void Viewport::update_frame_time(qint64 paint_ns)
+{
+    if (_type != TIME_VIEW || !_view.session().is_running_status()) {
+        _frame_timer.invalidate();
+        return;
+    }
+
+    if (!_frame_timer.isValid()) {
+        _frame_timer.start();
+        _frame_paints = 0;
+        _frame_paint_sum = 0;
+        _frame_paint_max = 0;
+    }
+
+    _frame_paints++;
+    _frame_paint_sum += paint_ns;
+    _frame_paint_max = max(_frame_paint_max, paint_ns);
+
+    const qint64 period = _frame_timer.elapsed();
+    if (period < FrameTimePeriod)
+        return;
+
+    const double avg_ms = _frame_paint_sum / 1e6 / _frame_paints;
+    const double max_ms = _frame_paint_max / 1e6;
+    const double fps = _frame_paints * 1000.0 / period;
+
+    if (_view.session().get_device()->get_work_mode() == DSO) {
+        data::DsoSnapshot *dso = (data::DsoSnapshot*)_view.session().get_snapshot(SR_CHANNEL_DSO);
+        data::DsoSnapshot::FrameCounters c;
+        dso->get_frame_counters(c);
+
+        // The frames replaced before a paint took them were not shown
+        dsv_dbg("Frame time: %.1f fps, paint avg %.2fms max %.2fms, frames %llu, dropped %llu",
+                fps, avg_ms, max_ms,
+                (unsigned long long)(c.published - _frame_published),
+                (unsigned long long)(c.dropped - _frame_dropped));
+
+        _frame_published = c.published;
+        _frame_dropped = c.dropped;
+    }
+    else {
+        dsv_dbg("Frame time: %.1f fps, paint avg %.2fms max %.2fms", fps, avg_ms, max_ms);
+    }
+
+    _frame_timer.restart();
+    _frame_paints = 0;
+    _frame_paint_sum = 0;
+    _frame_paint_max = 0;
 }
 
 void Viewport::paintCursors(QPainter &p)
@@ -77,6 +77,7 @@ public:
     static const double DragDamping;
     static const int SnapMinSpace = 10;
     static const int WaitLoopTime = 400;
+    static const int FrameTimePeriod = 1000;  // ms between the frame-time reports
     enum ActionType {
         NO_ACTION,
 
@@ -133,6 +134,7 @@ protected:
 
 private:
     void doPaint();
+    void update_frame_time(qint64 paint_ns);
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
@@ -221,6 +223,15 @@ private:
     double      _hover_sig_value;
 
     QElapsedTimer   _elapsed_time;
+
+    // Paint time of the frames while collecting, a stalled paint shows in the max
+    QElapsedTimer   _frame_timer;
+    uint64_t        _frame_paints;
+    qint64          _frame_paint_sum;
+    qint64          _frame_paint_max;
+    uint64_t        _frame_published;
+    uint64_t        _frame_dropped;
+
     QTimer          _drag_timer;
     int             _drag_strength;
     bool            _dso_xm_valid;
@@ -0,0 +1,379 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2022 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+/*
+ * The benchmark of the LogicSnapshot hot paths.
+ * Synthetic captures are fed as LA_CROSS_DATA packets, then the queries of
+ * the view, the search dock and the decoder are timed.
+ *
+ * usage: DSView-bench [sample count]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "pv/data/logicsnapshot.h"
+#include "log/xlog.h"
+
+using pv::data::LogicSnapshot;
+
+// The logs of the snapshot go nowhere
+xlog_writer *dsv_log = NULL;
+
+namespace {
+
+typedef std::chrono::steady_clock bench_clock;
+
+const uint64_t PacketSamples = 1 << 20;
+const uint16_t ViewWidth = 1920;
+const uint16_t TogMaxScale = 10;
+const double   MaxQuerySeconds = 2.0;
+
+inline double elapsed(bench_clock::time_point t0)
+{
+    return std::chrono::duration<double>(bench_clock::now() - t0).count();
+}
+
+// xorshift64*
+struct Random
+{
+    uint64_t s;
+
+    explicit Random(uint64_t seed) : s(seed ? seed : 1){}
+
+    inline uint64_t next(){
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 2685821657736338717ULL;
+    }
+};
+
+// One channel toggles after random runs of mean run_length samples
+struct ChannelGen
+{
+    bool     level;
+    uint64_t run;
+
+    uint64_t next_word(Random &rnd, uint64_t run_length)
+    {
+        uint64_t word = 0;
+        uint64_t pos = 0;
+
+        while (pos < 64)
+        {
+            if (run == 0){
+                level = !level;
+                run = 1 + rnd.next() % (2 * run_length);
+            }
+
+            uint64_t n = (run < 64 - pos) ? run : 64 - pos;
+            if (level){
+                uint64_t mask = (n == 64) ? ~0ULL : ((1ULL << n) - 1);
+                word |= mask << pos;
+            }
+            pos += n;
+            run -= n;
+        }
+        return word;
+    }
+};
+
+// The high-water mark of the whole process, not of one case
+uint64_t max_rss_kb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return pmc.PeakWorkingSetSize / 1024;
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+struct BenchCase
+{
+    int      channels;
+    uint64_t run_length; // mean samples between toggles
+};
+
+// Feed the capture, returns the seconds spent in the snapshot
+double ingest(LogicSnapshot &snapshot, const BenchCase &bc, uint64_t sample_count)
+{
+    std::vector<sr_channel> probes(bc.channels);
+    std::vector<GSList> list(bc.channels);
+
+    for (int i = 0; i < bc.channels; i++){
+        memset(&probes[i], 0, sizeof(sr_channel));
+        probes[i].index = i;
+        probes[i].type = SR_CHANNEL_LOGIC;
+        probes[i].enabled = true;
+        list[i].data = &probes[i];
+        list[i].next = (i + 1 < bc.channels) ? &list[i + 1] : NULL;
+    }
+
+    Random rnd(bc.channels * 1000003ULL + bc.run_length);
+    std::vector<ChannelGen> gens(bc.channels);
+    std::vector<uint64_t> buf;
+    double seconds = 0;
+
+    for (auto &g : gens){
+        g.level = false;
+        g.run = 1 + rnd.next() % (2 * bc.run_length);
+    }
+
+    // As the session does before a capture
+    snapshot.init();
+
+    for (uint64_t pos = 0; pos < sample_count; pos += PacketSamples)
+    {
+        uint64_t words = ((sample_count - pos < PacketSamples) ? sample_count - pos : PacketSamples) / 64;
+
+        // The words of all channels are interleaved
+        buf.resize(words * bc.channels);
+        for (uint64_t w = 0; w < words; w++){
+            for (int ch = 0; ch < bc.channels; ch++){
+                buf[w * bc.channels + ch] = gens[ch].next_word(rnd, bc.run_length);
+            }
+        }
+
+        sr_datafeed_logic logic;
+        memset(&logic, 0, sizeof(logic));
+        logic.format = LA_CROSS_DATA;
+        logic.length = buf.size() * sizeof(uint64_t);
+        logic.data = buf.data();
+
+        bench_clock::time_point t0 = bench_clock::now();
+        if (pos == 0)
+            snapshot.first_payload(logic, sample_count, &list[0], true);
+        else
+            snapshot.append_payload(logic);
+        seconds += elapsed(t0);
+    }
+
+    snapshot.capture_ended();
+    return seconds;
+}
+
+// Frames of the view at three zoom levels, returns ms per frame
+double bench_display(LogicSnapshot &snapshot, uint64_t sample_count)
+{
+    std::vector<std::pair<bool, bool>> edges;
+    std::vector<std::pair<uint16_t, bool>> togs;
+    const double zooms[] = {(double)sample_count / ViewWidth, 1000, 10};
+    Random rnd(7);
+    int frames = 0;
+
+    bench_clock::time_point t0 = bench_clock::now();
+
+    for (double spp : zooms)
+    {
+        uint64_t span = (uint64_t)(spp * ViewWidth);
+        if (span >= sample_count)
+            span = sample_count - 1;
+
+        for (int i = 0; i < 20; i++)
+        {
+            uint64_t start = (span + 1 < sample_count) ? rnd.next() % (sample_count - span) : 0;
+            uint64_t end = start + span;
+            snapshot.get_display_edges(edges, togs, start, end, ViewWidth, ViewWidth / TogMaxScale,
+                                        start / spp, spp, 0);
+            frames++;
+        }
+    }
+
+    return elapsed(t0) * 1000 / frames;
+}
+
+// Walk the edges of channel 0 forward, returns edges per second
+double bench_nxt_edge(LogicSnapshot &snapshot, uint64_t sample_count, uint64_t &count)
+{
+    uint64_t index = 0;
+    bool sample = snapshot.get_sample(0, 0);
+    count = 0;
+
+    bench_clock::time_point t0 = bench_clock::now();
+
+    while (snapshot.get_nxt_edge(index, sample, sample_count, 1, 0))
+    {
+        sample = !sample;
+        count++;
+
+        if ((count & 0xfff) == 0 && elapsed(t0) > MaxQuerySeconds)
+            break;
+    }
+
+    return count / elapsed(t0);
+}
+
+// Walk the edges of channel 0 backward, returns edges per second
+double bench_pre_edge(LogicSnapshot &snapshot, uint64_t sample_count, uint64_t &count)
+{
+    uint64_t index = sample_count - 1;
+    bool sample = snapshot.get_sample(index, 0);
+    count = 0;
+
+    bench_clock::time_point t0 = bench_clock::now();
+
+    while (index > 0)
+    {
+        uint64_t last = index;
+
+        index--;
+        if (!snapshot.get_pre_edge(index, sample, 1, 0))
+            break;
+
+        sample = !sample;
+        count++;
+
+        if (index >= last || ((count & 0xfff) == 0 && elapsed(t0) > MaxQuerySeconds))
+            break;
+    }
+
+    return count / elapsed(t0);
+}
+
+// Search a rising edge of channel 0 with channel 1 high, returns hits per second
+double bench_search(LogicSnapshot &snapshot, uint64_t sample_count, int channels, uint64_t &count)
+{
+    std::map<uint16_t, QString> pattern;
+    pattern[0] = "R";
+    if (channels > 1)
+        pattern[1] = "1";
+
+    const int64_t end = sample_count - 1;
+    int64_t index = 0;
+    count = 0;
+
+    bench_clock::time_point t0 = bench_clock::now();
+
+    while (index < end && snapshot.pattern_search(0, end, index, pattern, true))
+    {
+        count++;
+        index++;
+
+        if ((count & 0xff) == 0 && elapsed(t0) > MaxQuerySeconds)
+            break;
+    }
+
+    return count / elapsed(t0);
+}
+
+// Read all blocks of all channels, returns samples per second
+double bench_get_samples(LogicSnapshot &snapshot, uint64_t sample_count, int channels)
+{
+    uint64_t sum = 0;
+
+    bench_clock::time_point t0 = bench_clock::now();
+
+    for (int ch = 0; ch < channels; ch++)
+    {
+        uint64_t index = 0;
+
+        while (index < sample_count)
+        {
+            uint64_t end = 0;
+            const uint8_t *data = snapshot.get_samples(index, end, ch);
+
+            sum += data ? data[0] : snapshot.get_sample(index, ch);
+            index = end;
+        }
+    }
+
+    double seconds = elapsed(t0);
+    if (sum == 1)
+        printf(" ");
+
+    return (double)sample_count * channels / seconds;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    uint64_t sample_count = 1ULL << 26;
+
+    if (argc > 1)
+        sample_count = strtoull(argv[1], NULL, 10);
+
+    sample_count = (sample_count + 63) / 64 * 64;
+    if (sample_count < PacketSamples)
+        sample_count = PacketSamples;
+
+    const BenchCase cases[] = {
+        {4, 1000000}, {4, 1000}, {4, 4},
+        {16, 1000000}, {16, 1000}, {16, 4},
+    };
+
+    printf("samples: %llu\n", (unsigned long long)sample_count);
+    printf("%4s %8s %10s %10s %10s %10s %10s %10s\n",
+           "ch", "run", "ingest", "display", "nxt_edge", "pre_edge", "search", "samples");
+    printf("%4s %8s %10s %10s %10s %10s %10s %10s\n",
+           "", "", "MS/s", "ms/frame", "K/s", "K/s", "K/s", "GS/s");
+
+    for (const BenchCase &bc : cases)
+    {
+        LogicSnapshot snapshot;
+        uint64_t nxt_count, pre_count, search_count;
+
+        double ingest_s = ingest(snapshot, bc, sample_count);
+        double display_ms = bench_display(snapshot, sample_count);
+        double nxt_rate = bench_nxt_edge(snapshot, sample_count, nxt_count);
+        double pre_rate = bench_pre_edge(snapshot, sample_count, pre_count);
+        double search_rate = bench_search(snapshot, sample_count, bc.channels, search_count);
+        double samples_rate = bench_get_samples(snapshot, sample_count, bc.channels);
+
+        printf("%4d %8llu %10.1f %10.3f %10.1f %10.1f %10.1f %10.2f\n",
+               bc.channels, (unsigned long long)bc.run_length,
+               sample_count / ingest_s / 1e6,
+               display_ms,
+               nxt_rate / 1e3,
+               pre_rate / 1e3,
+               search_rate / 1e3,
+               samples_rate / 1e9);
+        fflush(stdout);
+
+        snapshot.free_data();
+    }
+
+    printf("max_rss_so_far: %.1f MB\n", max_rss_kb() / 1024.0);
+
+    return 0;
+}
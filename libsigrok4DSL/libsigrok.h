@@ -387,6 +387,10 @@ struct sr_datafeed_logic {
     int format;
     /** for LA_SPLIT_DATA, indicate the channel index */
     uint16_t index;
+    /** for LA_SPLIT_DATA without data, the level of all the samples */
+    uint8_t level;
+    /** for LA_SPLIT_DATA, the bytes of the saved mipmap after the data, 0 if none */
+    uint32_t mipmap_length;
     uint16_t order;
 	uint16_t unitsize;
     uint16_t data_error;
@@ -33,6 +33,10 @@
 #undef LOG_PREFIX
 #define LOG_PREFIX "virtual-session: "
 
+/* Version 4: a logic block without toggles is an empty entry, its comment
+ * gives the level and the byte count. Same as CONST_BLOCK_COMMENT of DSView. */
+#define CONST_BLOCK_COMMENT "const %d %llu"
+
 /* size of payloads sent across the session bus */
 /** @cond PRIVATE */
 #define CHUNKSIZE (512 * 1024)
@@ -413,6 +417,57 @@ static int receive_data(int fd, int revents, const struct sr_dev_inst *sdi)
     return TRUE;
 }
 
+// The inner file directory of each channel, the disabled channels are not saved.
+static void make_channel_dir_map(const struct sr_dev_inst *sdi, struct session_vdev *vdev, int chan_num)
+{
+    struct session_packet_buffer *pack_buffer;
+    char file_name[32];
+    int ch_index;
+    int channel_dex;
+    const int file_max_channel_count = 128;
+
+    pack_buffer = vdev->packet_buffer;
+    channel_dex = 0;
+
+    for (ch_index = 0; ch_index < chan_num; ch_index++)
+    {
+        while (1)
+        {
+            if (sdi->mode == LOGIC)
+                snprintf(file_name, sizeof(file_name)-1, "L-%d/0", channel_dex++);
+            else if (sdi->mode == DSO)
+                snprintf(file_name, sizeof(file_name)-1, "O-%d/0", channel_dex++);
+            
+            if (unzLocateFile(vdev->archive, file_name, 0) == UNZ_OK){
+                pack_buffer->channel_dir_map[ch_index] = channel_dex - 1;
+                break;
+            }
+            else if (channel_dex > file_max_channel_count){
+                break;
+            }                    
+        }
+    }
+}
+
+// Returns the level of a constant block entry and its byte count, -1 for a data entry.
+static int get_const_block(struct session_vdev *vdev, const unz_file_info64 *fileInfo,
+                           char *szComment, int comment_size, uint64_t *block_size)
+{
+    int const_level;
+    unsigned long long const_bytes;
+
+    szComment[min(fileInfo->size_file_comment, (uint64_t)(comment_size - 1))] = '\0';
+    *block_size = fileInfo->uncompressed_size;
+
+    if (vdev->version >= 4 && fileInfo->uncompressed_size == 0
+        && sscanf(szComment, CONST_BLOCK_COMMENT, &const_level, &const_bytes) == 2)
+    {
+        *block_size = const_bytes;
+        return const_level ? 1 : 0;
+    }
+    return -1;
+}
+
 static int receive_data_logic_dso_v2(int fd, int revents, const struct sr_dev_inst *sdi)
 {
     struct session_vdev *vdev = NULL;
@@ -426,14 +481,15 @@ static int receive_data_logic_dso_v2(int fd, int revents, const struct sr_dev_in
     struct session_packet_buffer *pack_buffer;
     unz_file_info64 fileInfo;
     char szFilePath[15];
+    char szComment[64];
+    uint64_t block_size;
+    int const_level;
     int bToEnd;
     int read_chan_index; 
     int chan_num;
     uint8_t *ptrWrite;
     uint64_t *ptrWrite_64;
     int byte_align;
-    int channel_dex;
-    const int file_max_channel_count = 128;
 
     assert(sdi);
     assert(sdi->priv);
@@ -495,26 +551,7 @@ static int receive_data_logic_dso_v2(int fd, int revents, const struct sr_dev_in
           vdev->num_blocks = 1; // Only one data file.
 
         //Make dir index map
-        channel_dex = 0;
-
-        for (ch_index = 0; ch_index < chan_num; ch_index++)
-        {
-            while (1)
-            {
-                if (sdi->mode == LOGIC)
-                    snprintf(file_name, sizeof(file_name)-1, "L-%d/0", channel_dex++);
-                else if (sdi->mode == DSO)
-                    snprintf(file_name, sizeof(file_name)-1, "O-%d/0", channel_dex++);
-                
-                if (unzLocateFile(vdev->archive, file_name, 0) == UNZ_OK){
-                    pack_buffer->channel_dir_map[ch_index] = channel_dex - 1;
-                    break;
-                }
-                else if (channel_dex > file_max_channel_count){
-                    break;
-                }                    
-            }
-        }
+        make_channel_dir_map(sdi, vdev, chan_num);
     }
     pack_buffer = vdev->packet_buffer;
 
@@ -550,17 +587,22 @@ static int receive_data_logic_dso_v2(int fd, int revents, const struct sr_dev_in
                     return FALSE;
                 }
 
+                szComment[0] = '\0';
+
                 if (unzGetCurrentFileInfo64(vdev->archive, &fileInfo, szFilePath,
-                                    sizeof(szFilePath), NULL, 0, NULL, 0) != UNZ_OK)
+                                    sizeof(szFilePath), NULL, 0, szComment, sizeof(szComment) - 1) != UNZ_OK)
                 { 
                     sr_err("%s: unzGetCurrentFileInfo64 error.", __func__);
                     send_error_packet(sdi, vdev, &packet);
                     return FALSE;
                 }
 
+                // A constant block is expanded, nothing to read.
+                const_level = get_const_block(vdev, &fileInfo, szComment, sizeof(szComment), &block_size);
+
                 if (ch_index == 0){  
                     // Alloc the buffer for each channel to read block file data.
-                    pack_buffer->block_data_len = fileInfo.uncompressed_size;
+                    pack_buffer->block_data_len = block_size;
                     
                     if (pack_buffer->block_data_len > pack_buffer->block_buf_len)
                     {
@@ -584,13 +626,18 @@ static int receive_data_logic_dso_v2(int fd, int revents, const struct sr_dev_in
                 }
                 else
                 {
-                    if (pack_buffer->block_data_len != fileInfo.uncompressed_size){
+                    if (pack_buffer->block_data_len != block_size){
                         sr_err("The block size is not coincident:%s", file_name);
                         send_error_packet(sdi, vdev, &packet);
                         return FALSE;
                     }
                 }
 
+                if (const_level != -1){
+                    memset(pack_buffer->block_bufs[ch_index], const_level ? 0xff : 0, block_size);
+                    continue;
+                }
+
                 // Read the data to buffer. 
                 if (unzOpenCurrentFile(vdev->archive) != UNZ_OK)
                 {
@@ -703,6 +750,200 @@ static int receive_data_logic_dso_v2(int fd, int revents, const struct sr_dev_in
     return TRUE;
 }
 
+/*
+ * Version 4 logic file: each block of each channel goes out as it is stored,
+ * one LA_SPLIT_DATA packet per channel, no interleave.
+ * A constant block has no data, only its level.
+ * The mipmap entry "M-<ch>/<block>" of a block is optional, it follows the data.
+ */
+static int receive_data_logic_split(int fd, int revents, const struct sr_dev_inst *sdi)
+{
+    struct session_vdev *vdev = NULL;
+    struct sr_datafeed_packet packet;
+    struct sr_datafeed_logic logic;
+    char file_name[32];
+    int ch_index;
+    struct session_packet_buffer *pack_buffer;
+    unz_file_info64 fileInfo;
+    char szFilePath[15];
+    char szComment[64];
+    uint64_t block_size;
+    uint64_t mipmap_size;
+    int const_level;
+    int chan_num;
+    int ret;
+
+    assert(sdi);
+    assert(sdi->priv);
+    (void)fd;
+
+    packet.status = SR_PKT_OK;
+    vdev = sdi->priv;
+    chan_num = vdev->num_probes;
+
+    assert(vdev->archive);
+
+    if (chan_num < 1){
+        sr_err("%s: channel count < 1.", __func__);
+        return SR_ERR_ARG;
+    }
+    if (chan_num > SESSION_MAX_CHANNEL_COUNT){
+        sr_err("%s: channel count is to big.", __func__);
+        return SR_ERR_ARG;
+    }
+
+    if (vdev->packet_buffer == NULL){
+        vdev->cur_block = 0;
+
+        vdev->packet_buffer = malloc(sizeof(struct session_packet_buffer));
+        if (vdev->packet_buffer == NULL){
+            sr_err("%s: vdev->packet_buffer malloc failed", __func__);
+            return SR_ERR_MALLOC;
+        }
+        memset(vdev->packet_buffer, 0, sizeof(struct session_packet_buffer));
+
+        make_channel_dir_map(sdi, vdev, chan_num);
+    }
+    pack_buffer = vdev->packet_buffer;
+
+    // One block of all channels on each call.
+    if (vdev->cur_block < vdev->num_blocks && revents != -1)
+    {
+        for (ch_index = 0; ch_index < chan_num; ch_index++)
+        {
+            snprintf(file_name, sizeof(file_name)-1, "L-%d/%d", 
+                pack_buffer->channel_dir_map[ch_index], vdev->cur_block);
+
+            if (unzLocateFile(vdev->archive, file_name, 0) != UNZ_OK){
+                sr_err("can't locate zip inner file:\"%s\"", file_name);
+                send_error_packet(sdi, vdev, &packet);
+                return FALSE;
+            }
+
+            szComment[0] = '\0';
+
+            if (unzGetCurrentFileInfo64(vdev->archive, &fileInfo, szFilePath,
+                                sizeof(szFilePath), NULL, 0, szComment, sizeof(szComment) - 1) != UNZ_OK)
+            { 
+                sr_err("%s: unzGetCurrentFileInfo64 error.", __func__);
+                send_error_packet(sdi, vdev, &packet);
+                return FALSE;
+            }
+
+            const_level = get_const_block(vdev, &fileInfo, szComment, sizeof(szComment), &block_size);
+
+            if (ch_index == 0){
+                pack_buffer->block_data_len = block_size;
+            }
+            else if (pack_buffer->block_data_len != block_size){
+                sr_err("The block size is not coincident:%s", file_name);
+                send_error_packet(sdi, vdev, &packet);
+                return FALSE;
+            }
+
+            if (block_size % 8 != 0){
+                sr_err("The block data is not align with 8 byte.");
+                send_error_packet(sdi, vdev, &packet);
+                return FALSE;
+            }
+
+            mipmap_size = 0;
+
+            if (const_level == -1)
+            {
+                snprintf(file_name, sizeof(file_name)-1, "M-%d/%d", 
+                    pack_buffer->channel_dir_map[ch_index], vdev->cur_block);
+
+                if (unzLocateFile(vdev->archive, file_name, 0) == UNZ_OK
+                    && unzGetCurrentFileInfo64(vdev->archive, &fileInfo, szFilePath,
+                                sizeof(szFilePath), NULL, 0, NULL, 0) == UNZ_OK)
+                {
+                    mipmap_size = fileInfo.uncompressed_size;
+                }
+
+                // The channels take turns on one buffer.
+                if (block_size + mipmap_size > pack_buffer->block_buf_len){
+                    safe_free(pack_buffer->block_bufs[0]);
+
+                    pack_buffer->block_bufs[0] = malloc(block_size + mipmap_size + 1);
+                    if (pack_buffer->block_bufs[0] == NULL){
+                        sr_err("%s: block buffer malloc failed", __func__);
+                        send_error_packet(sdi, vdev, &packet);
+                        return FALSE;
+                    }
+                    pack_buffer->block_buf_len = block_size + mipmap_size;
+                }
+
+                // A mipmap that can't be read is made again by the receiver.
+                if (mipmap_size > 0)
+                {
+                    if (unzOpenCurrentFile(vdev->archive) == UNZ_OK){
+                        ret = unzReadCurrentFile(vdev->archive, 
+                                (uint8_t*)pack_buffer->block_bufs[0] + block_size, mipmap_size);
+                        unzCloseCurrentFile(vdev->archive);
+
+                        if (ret < 0 || (uint64_t)ret != mipmap_size)
+                            mipmap_size = 0;
+                    }
+                    else{
+                        mipmap_size = 0;
+                    }
+                }
+
+                snprintf(file_name, sizeof(file_name)-1, "L-%d/%d", 
+                    pack_buffer->channel_dir_map[ch_index], vdev->cur_block);
+
+                if (unzLocateFile(vdev->archive, file_name, 0) != UNZ_OK){
+                    sr_err("can't locate zip inner file:\"%s\"", file_name);
+                    send_error_packet(sdi, vdev, &packet);
+                    return FALSE;
+                }
+
+                if (unzOpenCurrentFile(vdev->archive) != UNZ_OK)
+                {
+                    sr_err("can't open zip inner file:\"%s\"", file_name);
+                    send_error_packet(sdi, vdev, &packet);
+                    return FALSE;
+                }
+
+                ret = unzReadCurrentFile(vdev->archive, pack_buffer->block_bufs[0], block_size);
+                unzCloseCurrentFile(vdev->archive);
+
+                if (ret < 0 || (uint64_t)ret != block_size)
+                {
+                    sr_err("read zip inner file error:\"%s\"", file_name);
+                    send_error_packet(sdi, vdev, &packet);
+                    return FALSE;
+                }
+            }
+
+            packet.type = SR_DF_LOGIC;
+            packet.payload = &logic;
+            logic.format = LA_SPLIT_DATA;
+            logic.index = ch_index;
+            logic.order = 0;
+            logic.length = block_size;
+            logic.level = const_level == 1;
+            logic.mipmap_length = mipmap_size;
+            logic.data = (const_level == -1) ? pack_buffer->block_bufs[0] : NULL;
+            ds_data_forward(sdi, &packet);
+        }
+
+        vdev->cur_block++;
+    }
+
+    // Check if is complete.
+    if (vdev->cur_block >= vdev->num_blocks || revents == -1)
+    {
+        packet.type = SR_DF_END;
+        ds_data_forward(sdi, &packet);
+        sr_session_source_remove(-1);
+        close_archive(vdev);
+        free_temp_buffer(vdev);
+    }
+
+    return TRUE;
+}
 
 /* driver callbacks */
 static int dev_clear(void);
@@ -1448,7 +1689,10 @@ static int dev_acquisition_start(struct sr_dev_inst *sdi, void *cb_data)
     }
 
     /* freewheeling source */
-    if ((sdi->mode == LOGIC && vdev->version > 1) 
+    if (sdi->mode == LOGIC && vdev->version >= 4){
+        sr_session_source_add(-1, 0, 0, receive_data_logic_split, sdi);
+    }
+    else if ((sdi->mode == LOGIC && vdev->version > 1) 
             || (sdi->mode == DSO && vdev->version > 2)){
         sr_session_source_add(-1, 0, 0, receive_data_logic_dso_v2, sdi);
     }
@@ -1668,6 +1912,12 @@ static int sr_load_virtual_device_session(struct sr_dev_inst *sdi)
                     version = strtoull(val, NULL, 10);
                     sr_info("The 'header' file format version:%d", version);
                 }
+                else if (!strcmp(keys[j], "codec"))
+                {
+                    // Informational only, the zip entries tell their method,
+                    // a version 4 loader reads both stored and deflated blocks
+                    sr_info("The 'header' block codec:%s", val);
+                }
             }
         }
 
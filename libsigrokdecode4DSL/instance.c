@@ -421,8 +421,6 @@ SRD_API struct srd_decoder_inst *srd_inst_new(struct srd_session *sess,
         goto err;
 	}
 
-    PyGILState_Release(gstate);
-
 	di->condition_list = NULL;
     di->match_array = 0;
 	di->abs_start_samplenum = 0;
@@ -448,10 +446,15 @@ SRD_API struct srd_decoder_inst *srd_inst_new(struct srd_session *sess,
 	g_cond_init(&di->handled_all_samples_cond);
 	g_mutex_init(&di->data_mutex);
 
-	/* Instance takes input from a frontend by default. */
+	/*
+	 * Instance takes input from a frontend by default. The list is
+	 * walked by srd_inst_find_by_obj() of other sessions under the GIL.
+	 */
 	sess->di_list = g_slist_append(sess->di_list, di);
 	srd_dbg("Creating new %s instance %s.", decoder_id, di->inst_id);
 
+	PyGILState_Release(gstate);
+
 	return di;
 
 err:
@@ -537,6 +540,8 @@ SRD_API int srd_inst_stack(struct srd_session *sess,
 		struct srd_decoder_inst *di_bottom,
 		struct srd_decoder_inst *di_top)
 {
+	PyGILState_STATE gstate;
+
 	if (!sess)
 		return SRD_ERR_ARG;
 
@@ -545,11 +550,18 @@ SRD_API int srd_inst_stack(struct srd_session *sess,
 		return SRD_ERR_ARG;
 	}
 
+	gstate = PyGILState_Ensure();
+
 	if (g_slist_find(sess->di_list, di_top)) {
 		/* Remove from the unstacked list. */
 		sess->di_list = g_slist_remove(sess->di_list, di_top);
 	}
 
+	/* Stack on top of source di. */
+	di_bottom->next_di = g_slist_append(di_bottom->next_di, di_top);
+
+	PyGILState_Release(gstate);
+
 	/*
 	 * Check if there's at least one matching input/output pair
 	 * for the stacked PDs. We warn if that's not the case, but it's
@@ -571,9 +583,6 @@ SRD_API int srd_inst_stack(struct srd_session *sess,
 		srd_warn("No matching in-/output when stacking %s onto %s.",
 			di_top->inst_id, di_bottom->inst_id);
 
-	/* Stack on top of source di. */
-	di_bottom->next_di = g_slist_append(di_bottom->next_di, di_top);
-
 	srd_dbg("Stacking %s onto %s.", di_top->inst_id, di_bottom->inst_id);
 
 	return SRD_OK;
@@ -935,6 +944,291 @@ static gboolean all_terms_match(struct srd_decoder_inst *di,
 	return TRUE;
 }
 
+/** @private */
+#define MATCH_MAX_CONDS		32
+#define MATCH_MAX_CHANNELS	64
+
+/**
+ * A condition compiled for the word-parallel matcher.
+ *
+ * Every term mask holds one bit per decoder channel. A condition either
+ * has channel terms only, or is a single SKIP term.
+ *
+ * @private
+ */
+struct match_cond {
+	uint64_t high;
+	uint64_t low;
+	uint64_t rise;
+	uint64_t fall;
+	uint64_t edge;
+	uint64_t no_edge;
+	struct srd_term *skip;
+};
+
+/**
+ * Compile the condition list of a decoder instance into per-channel masks.
+ *
+ * @param di The decoder instance. Must not be NULL.
+ * @param conds Array of at least MATCH_MAX_CONDS entries.
+ * @param num_conds Will be set to the number of compiled conditions,
+ *                  including NULL conditions which never match.
+ * @param used Will be set to the mask of channels referenced by any term.
+ *
+ * @retval TRUE The conditions can be handled by match_words().
+ * @retval FALSE The sample-by-sample matcher must be used.
+ *
+ * @private
+ */
+static gboolean compile_conditions(struct srd_decoder_inst *di,
+		struct match_cond *conds, int *num_conds, uint64_t *used)
+{
+	GSList *l, *t;
+	struct srd_term *term;
+	struct match_cond *mc;
+	uint64_t bit;
+	int n;
+
+	if (!di->dec_channelmap || di->dec_num_channels > MATCH_MAX_CHANNELS)
+		return FALSE;
+
+	*used = 0;
+
+	for (l = di->condition_list, n = 0; l; l = l->next, n++) {
+		if (n == MATCH_MAX_CONDS)
+			return FALSE;
+
+		mc = &conds[n];
+		memset(mc, 0, sizeof(struct match_cond));
+
+		for (t = l->data; t; t = t->next) {
+			term = t->data;
+
+			if (term->type == SRD_TERM_SKIP) {
+				/* skip:0 and mixed skip terms keep the scalar semantics. */
+				if (t != l->data || t->next)
+					return FALSE;
+				if (term->num_samples_already_skipped >= term->num_samples_to_skip)
+					return FALSE;
+				mc->skip = term;
+				continue;
+			}
+
+			if (term->channel < 0 || term->channel >= di->dec_num_channels)
+				return FALSE;
+
+			bit = 1ULL << term->channel;
+			*used |= bit;
+
+			switch (term->type) {
+			case SRD_TERM_HIGH:
+				mc->high |= bit;
+				break;
+			case SRD_TERM_LOW:
+				mc->low |= bit;
+				break;
+			case SRD_TERM_RISING_EDGE:
+				mc->rise |= bit;
+				break;
+			case SRD_TERM_FALLING_EDGE:
+				mc->fall |= bit;
+				break;
+			case SRD_TERM_EITHER_EDGE:
+				mc->edge |= bit;
+				break;
+			case SRD_TERM_NO_EDGE:
+				mc->no_edge |= bit;
+				break;
+			default:
+				return FALSE;
+			}
+		}
+	}
+
+	*num_conds = n;
+
+	return TRUE;
+}
+
+/**
+ * Load 64 samples of one channel, starting at a 64-sample aligned word
+ * of the current chunk. Samples beyond the chunk read as zero.
+ *
+ * @private
+ */
+static inline uint64_t inbuf_word(const struct srd_decoder_inst *di,
+		int ch, uint64_t word, uint64_t num_bytes)
+{
+	const uint8_t *ptr;
+	uint64_t offset, value;
+	int i;
+
+	ptr = *(di->inbuf + ch);
+	if (ptr == NULL)
+		return *(di->inbuf_const + ch) ? ~0ULL : 0ULL;
+
+	offset = word * 8;
+
+	if (offset + 8 <= num_bytes) {
+		memcpy(&value, ptr + offset, 8);
+		return GUINT64_FROM_LE(value);
+	}
+
+	value = 0;
+	for (i = 0; offset + i < num_bytes; i++)
+		value |= (uint64_t)ptr[offset + i] << (8 * i);
+
+	return value;
+}
+
+/**
+ * Word-parallel version of the find_match() sample loop.
+ *
+ * Scans 64 samples per step, evaluating every term with bitwise operations
+ * on the packed inbuf words. Leaves di in the same state as the
+ * sample-by-sample loop would: abs_cur_samplenum, match_array,
+ * old_pins_array and the SKIP counters.
+ *
+ * @private
+ */
+static gboolean match_words(struct srd_decoder_inst *di,
+		struct match_cond *conds, int num_conds, uint64_t used)
+{
+	uint64_t cur[MATCH_MAX_CHANNELS];
+	uint64_t pre[MATCH_MAX_CHANNELS];
+	uint64_t carry[MATCH_MAX_CHANNELS];
+	uint64_t num_bytes, first, word, last_word, valid, any, hit, cm, bit, sample_pos;
+	uint64_t skip_left;
+	struct match_cond *mc;
+	int ch, j, first_bit, pos;
+
+	first = di->abs_cur_samplenum - di->abs_start_samplenum;
+	num_bytes = (di->abs_end_samplenum - di->abs_start_samplenum + 7) / 8;
+	last_word = (di->abs_end_samplenum - di->abs_start_samplenum - 1) >> 6;
+
+	/* The sample before the first one is the old pin state. */
+	for (ch = 0; ch < di->dec_num_channels; ch++) {
+		if (used & (1ULL << ch))
+			carry[ch] = di->old_pins_array->data[ch] ? 1 : 0;
+	}
+
+	first_bit = first & 63;
+
+	for (word = first >> 6; word <= last_word; word++) {
+		for (ch = 0; ch < di->dec_num_channels; ch++) {
+			if (!(used & (1ULL << ch)))
+				continue;
+			cur[ch] = inbuf_word(di, ch, word, num_bytes);
+			pre[ch] = (cur[ch] << 1) | carry[ch];
+			if (first_bit > 0) {
+				/* Only the first word starts in its middle. */
+				pre[ch] &= ~(1ULL << first_bit);
+				pre[ch] |= (uint64_t)di->old_pins_array->data[ch] << first_bit;
+			}
+			carry[ch] = cur[ch] >> 63;
+		}
+
+		valid = ~0ULL << first_bit;
+		if (word == last_word)
+			valid &= ~0ULL >> (63 - ((di->abs_end_samplenum - di->abs_start_samplenum - 1) & 63));
+
+		any = 0;
+		for (j = 0; j < num_conds; j++) {
+			mc = &conds[j];
+			if (mc->skip) {
+				skip_left = mc->skip->num_samples_to_skip - mc->skip->num_samples_already_skipped;
+				sample_pos = first + skip_left;
+				any |= ((sample_pos >> 6) == word) ? 1ULL << (sample_pos & 63) : 0;
+				continue;
+			}
+			cm = valid;
+			for (ch = 0; cm && ch < di->dec_num_channels; ch++) {
+				bit = 1ULL << ch;
+				if (!(used & bit))
+					continue;
+				if (mc->high & bit)
+					cm &= cur[ch];
+				if (mc->low & bit)
+					cm &= ~cur[ch];
+				if (mc->rise & bit)
+					cm &= ~pre[ch] & cur[ch];
+				if (mc->fall & bit)
+					cm &= pre[ch] & ~cur[ch];
+				if (mc->edge & bit)
+					cm &= pre[ch] ^ cur[ch];
+				if (mc->no_edge & bit)
+					cm &= ~(pre[ch] ^ cur[ch]);
+			}
+			/* A NULL condition has no terms, and never matches. */
+			if (mc->high | mc->low | mc->rise | mc->fall | mc->edge | mc->no_edge)
+				any |= cm;
+		}
+		any &= valid;
+
+		if (any) {
+			pos = __builtin_ctzll(any);
+			hit = 1ULL << pos;
+			di->abs_cur_samplenum = di->abs_start_samplenum + (word << 6) + pos;
+
+			for (j = 0; j < num_conds; j++) {
+				mc = &conds[j];
+				if (mc->skip) {
+					sample_pos = di->abs_cur_samplenum - di->abs_start_samplenum;
+					skip_left = mc->skip->num_samples_to_skip - mc->skip->num_samples_already_skipped;
+					if (sample_pos - first == skip_left) {
+						mc->skip->num_samples_already_skipped = mc->skip->num_samples_to_skip;
+						di->match_array |= (1 << j);
+					} else {
+						mc->skip->num_samples_already_skipped += sample_pos - first + 1;
+					}
+					continue;
+				}
+				if (!(mc->high | mc->low | mc->rise | mc->fall | mc->edge | mc->no_edge))
+					continue;
+				cm = hit;
+				for (ch = 0; cm && ch < di->dec_num_channels; ch++) {
+					bit = 1ULL << ch;
+					if (!(used & bit))
+						continue;
+					if (mc->high & bit)
+						cm &= cur[ch];
+					if (mc->low & bit)
+						cm &= ~cur[ch];
+					if (mc->rise & bit)
+						cm &= ~pre[ch] & cur[ch];
+					if (mc->fall & bit)
+						cm &= pre[ch] & ~cur[ch];
+					if (mc->edge & bit)
+						cm &= pre[ch] ^ cur[ch];
+					if (mc->no_edge & bit)
+						cm &= ~(pre[ch] ^ cur[ch]);
+				}
+				if (cm)
+					di->match_array |= (1 << j);
+			}
+
+			update_old_pins_array(di);
+			di->abs_cur_matched = TRUE;
+			return TRUE;
+		}
+
+		first_bit = 0;
+	}
+
+	/* No match in this chunk, leave the state as after the last sample. */
+	for (j = 0; j < num_conds; j++) {
+		if (conds[j].skip)
+			conds[j].skip->num_samples_already_skipped += di->abs_end_samplenum - di->abs_cur_samplenum;
+	}
+
+	di->abs_cur_samplenum = di->abs_end_samplenum - 1;
+	update_old_pins_array(di);
+	di->abs_cur_samplenum = di->abs_end_samplenum;
+	di->abs_cur_matched = FALSE;
+
+	return FALSE;
+}
+
 static gboolean 
 find_match(struct srd_decoder_inst *di)
 {
@@ -942,6 +1236,9 @@ find_match(struct srd_decoder_inst *di)
 	GSList *l, *cond;
     gboolean skip_allow;
     gboolean all_skip_allow = TRUE;
+    struct match_cond conds[MATCH_MAX_CONDS];
+    int num_conds;
+    uint64_t used_channels;
 
 	/* Caller ensures di != NULL. */
 
@@ -969,6 +1266,10 @@ find_match(struct srd_decoder_inst *di)
     if (di->abs_cur_matched)
         di->abs_cur_samplenum++;
 
+    if (di->abs_cur_samplenum < di->abs_end_samplenum
+        && compile_conditions(di, conds, &num_conds, &used_channels))
+        return match_words(di, conds, num_conds, used_channels);
+
     while (di->abs_cur_samplenum < di->abs_end_samplenum) {
 
         /* Check whether the current sample matches at least one of the conditions (logical OR). */
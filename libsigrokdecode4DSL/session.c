@@ -43,6 +43,12 @@ SRD_PRIV int srd_call_sub_decoder_end(struct srd_decoder_inst *di, char **error)
 
 /** @cond PRIVATE */
 
+/*
+ * Decoder instances of one session may run while other sessions are
+ * created or destroyed from another thread. The list is walked with the
+ * GIL held (see srd_inst_find_by_obj()), so it is only changed with the
+ * GIL held as well.
+ */
 SRD_PRIV GSList *sessions = NULL;
 SRD_PRIV int max_session_id = -1;
 
@@ -64,6 +70,7 @@ SRD_PRIV int max_session_id = -1;
 SRD_API int srd_session_new(struct srd_session **sess)
 {
 	struct srd_session *se = NULL;
+	PyGILState_STATE gstate;
 
 	if (!sess)
 		return SRD_ERR_ARG;
@@ -75,11 +82,15 @@ SRD_API int srd_session_new(struct srd_session **sess)
 	}
 	memset(se, 0, sizeof(struct srd_session));
 
+	gstate = PyGILState_Ensure();
+
 	se->session_id = ++max_session_id;
 
 	/* Keep a list of all sessions, so we can clean up as needed. */
 	sessions = g_slist_append(sessions, se);
 
+	PyGILState_Release(gstate);
+
 	*sess = se;
 
 	//srd_info("Creating session %d.", (*sess)->session_id);
@@ -344,16 +355,21 @@ SRD_API int srd_session_terminate_reset(struct srd_session *sess)
 SRD_API int srd_session_destroy(struct srd_session *sess)
 {
 	int session_id;
+	PyGILState_STATE gstate;
 
 	if (!sess)
 		return SRD_ERR_ARG;
 
+	/* Unlink first, so no other session's decoder can reach our instances. */
+	gstate = PyGILState_Ensure();
+	sessions = g_slist_remove(sessions, sess);
+	PyGILState_Release(gstate);
+
 	session_id = sess->session_id;
 	if (sess->di_list)
 		srd_inst_free_all(sess);
 	if (sess->callbacks)
 		g_slist_free_full(sess->callbacks, g_free);
-	sessions = g_slist_remove(sessions, sess);
 	g_free(sess);
 
 	srd_info("Destroyed session %d.", session_id);